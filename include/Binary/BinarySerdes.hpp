@@ -0,0 +1,278 @@
+#ifndef hpp_BinarySerdes_hpp
+#define hpp_BinarySerdes_hpp
+
+// We need the reflection code and the type traits from the JSON serializer
+#include "JSON/JSONSerdes.hpp"
+#include <iterator>
+
+/** Reflection based binary serialization.
+    This is the binary counterpart of JSONSerdes: the same aggregates are walked with the same reflection code, but the
+    output is a compact binary format. Numbers are stored in binary form (so there's no formatting or parsing) and
+    aggregates keys can be stored as member indices instead of names.
+
+    The walker below doesn't know about the actual format, it's given as a policy (see CBOR.hpp and MsgPack.hpp).
+    A format policy must provide these static functions:
+    @code
+        // Encoding
+        writeUnsigned(sink, value); writeNegative(sink, magnitude); writeBool(sink, b); writeFloat(sink, f);
+        writeDouble(sink, d); writeString(sink, text, len); writeArray(sink, count); writeMap(sink, count);
+        // Decoding (all return false if the next item isn't of the expected type)
+        readInteger(reader, magnitude, negative); readDouble(reader, d); readBool(reader, b);
+        readString(reader, text, len); readArray(reader, count); readMap(reader, count);
+        isString(reader); skip(reader, depth);
+    @endcode
+    Negative integers are given as a magnitude, where the value is (-1 - magnitude), so the complete int64 range fits. */
+namespace Binary
+{
+    /** How to encode the aggregate keys */
+    enum KeyMode
+    {
+        Names   = 0,    //!< Keys are the member names (self describing, like JSON)
+        Indices = 1,    //!< Keys are the member indices. This is smaller and faster, but both sides must use the same struct
+    };
+
+    /** The maximum nesting depth accepted when decoding */
+    static constexpr size_t MaxDepth = 64;
+
+    /** A bounds checked reader on a binary buffer */
+    struct Reader
+    {
+        const uint8 *   data;
+        size_t          len;
+        size_t          pos;
+
+        /** Check if the given amount of bytes is available */
+        bool has(const size_t n) const { return len - pos >= n; }
+        /** Get the next byte without consuming it */
+        bool peek(uint8 & b) const { if (pos >= len) return false; b = data[pos]; return true; }
+        /** Consume the next byte */
+        bool byte(uint8 & b) { if (pos >= len) return false; b = data[pos++]; return true; }
+        /** Consume a big endian unsigned integer of the given size */
+        bool bigEndian(const size_t bytes, uint64 & v)
+        {
+            if (!has(bytes)) return false;
+            v = 0;
+            for (size_t i = 0; i < bytes; i++) v = (v << 8) | data[pos++];
+            return true;
+        }
+        /** Consume the given amount of bytes */
+        bool bytes(const uint64 n, const char *& p)
+        {
+            if (n > len - pos) return false;
+            p = (const char*)data + pos; pos += (size_t)n;
+            return true;
+        }
+
+        Reader(const ROString & in) : data((const uint8*)in.getData()), len(in.getLength()), pos(0) {}
+    };
+
+    namespace Details
+    {
+        /** Write the given value in big endian order with the given size */
+        template <Tools::Sink S>
+        inline void writeBigEndian(S & out, const uint64 v, const size_t bytes)
+        {
+            char b[8];
+            for (size_t i = 0; i < bytes; i++) b[i] = (char)(v >> (8 * (bytes - 1 - i)));
+            out.write(b, bytes);
+        }
+
+        /** Convert a decoded integer to the given type. @return false if it doesn't fit */
+        template <typename T>
+        bool fitInteger(const uint64 magnitude, const bool negative, T & out)
+        {
+            if (magnitude > (uint64)std::numeric_limits<T>::max()) return false;
+            if (!negative) { out = (T)magnitude; return true; }
+            if constexpr (std::is_signed_v<T>) { out = (T)(-(int64)magnitude - 1); return true; }
+            else return false;
+        }
+
+        // Dynamic and fixed size containers
+        template <typename>                     struct IsSequence : std::false_type { };
+        template <typename T, typename... Ts>   struct IsSequence<std::vector<T, Ts...>> : std::true_type { };
+        template <typename T, size_t N>         struct IsSequence<std::array<T, N>> : std::true_type { };
+        template <typename C>                   struct IsSequence<Base64Bytes<C>> : IsSequence<C> { };
+        template <typename T>                   constexpr bool is_sequence_v = IsSequence<T>::value;
+        template <typename T>                   constexpr bool is_resizable_v = requires(T & t) { t.resize(1); };
+
+        /** Encode any supported type with the given format */
+        template <typename F, Tools::Sink S, typename U>
+        void encode(S & out, const U & t, const KeyMode keys)
+        {
+            using T = std::decay_t<U>;
+            if constexpr (std::is_enum_v<T>) encode<F>(out, static_cast<std::underlying_type_t<T>>(t), keys);
+            else if constexpr (std::is_same_v<T, bool>) F::writeBool(out, t);
+            else if constexpr (std::is_integral_v<T>)
+            {
+                if constexpr (std::is_signed_v<T>)
+                    if (t < 0) return F::writeNegative(out, (uint64)(-1 - (int64)t));
+                F::writeUnsigned(out, (uint64)t);
+            }
+            else if constexpr (std::is_same_v<T, float>) F::writeFloat(out, t);
+            else if constexpr (std::is_floating_point_v<T>) F::writeDouble(out, (double)t);
+            else if constexpr (::Details::is_bounded_char_array_v<U>) F::writeString(out, t, strnlen(t, sizeof(t)));
+            else if constexpr (std::is_same_v<T, RWString> || std::is_same_v<T, ROString>) F::writeString(out, t.getData(), t.getLength());
+            else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) F::writeString(out, t.data(), t.length());
+            else if constexpr (std::is_convertible_v<T, const char *>) { const char * s = t; F::writeString(out, s, s ? strlen(s) : 0); }
+            else if constexpr (is_sequence_v<T> || std::is_array_v<U>)
+            {
+                F::writeArray(out, std::size(t));
+                for (auto const & elem : t) encode<F>(out, elem, keys);
+            }
+            else if constexpr (std::is_aggregate_v<T>)
+            {
+                const auto & members = Refl::Members::get_member_functors<T>(0);
+                F::writeMap(out, std::tuple_size_v<std::remove_cvref_t<decltype(members)>>);
+                std::apply([&out, &t, keys](auto const & ... args)
+                    {
+                        uint64 index = 0;
+                        ((keys == Indices ? F::writeUnsigned(out, index++) : F::writeString(out, args.name().getData(), args.name().getLength()),
+                          encode<F>(out, args.get(t), keys)), ...);
+                    }, members);
+            }
+            else static_assert(Refl::always_false_v<T>, "Can't serialize this type");
+        }
+
+        /** Decode any supported type with the given format.
+            @return An error message or null on success */
+        template <typename F, typename U>
+        const char * decode(Reader & in, U & t, const size_t depth)
+        {
+            using T = std::decay_t<U>;
+            if (depth > MaxDepth) return "Too deeply nested";
+            if constexpr (std::is_enum_v<T>)
+            {
+                std::underlying_type_t<T> v;
+                if (const char * err = decode<F>(in, v, depth)) return err;
+                t = static_cast<T>(v);
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                if (!F::readBool(in, t)) return "Expected boolean";
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                uint64 magnitude; bool negative;
+                if (!F::readInteger(in, magnitude, negative)) return "Expected integer";
+                if (!fitInteger(magnitude, negative, t)) return "Integer out of range for the destination type";
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                double v;
+                if (!F::readDouble(in, v)) return "Expected number";
+                t = static_cast<T>(v);
+            }
+            else if constexpr (::Details::is_bounded_char_array_v<U> || std::is_same_v<T, RWString> || std::is_same_v<T, std::string>)
+            {
+                const char * text; size_t len;
+                if (!F::readString(in, text, len)) return "Expected string";
+                if constexpr (std::is_same_v<T, std::string>) t.assign(text, len);
+                else if constexpr (std::is_same_v<T, RWString>) t = ROString(text, (int)len);
+                else
+                {
+                    if (len >= sizeof(t)) return "Given text is too large for the destination array";
+                    memcpy(t, text, len);
+                    memset(t + len, 0, sizeof(t) - len);
+                }
+            }
+            else if constexpr (is_sequence_v<T> || std::is_array_v<U>)
+            {
+                size_t count;
+                if (!F::readArray(in, count)) return "Expected array";
+                using V = std::iter_value_t<decltype(std::begin(t))>;
+                if constexpr (is_resizable_v<T>)
+                {
+                    // Each element takes at least one byte, so don't trust a count larger than the remaining data
+                    if (!in.has(count)) return "Invalid array size";
+                    t.clear(); t.resize(count);
+                }
+                else
+                {
+                    if (count > std::size(t)) return "Destination array is too small";
+                    for (auto & elem : t) elem = V{};
+                }
+                for (size_t i = 0; i < count; i++)
+                {
+                    if constexpr (std::is_same_v<V, bool>)
+                    {   // std::vector<bool> doesn't give references to its elements
+                        bool b;
+                        if (!F::readBool(in, b)) return "Expected boolean";
+                        t[i] = b;
+                    }
+                    else if (const char * err = decode<F>(in, t[i], depth + 1)) return err;
+                }
+            }
+            else if constexpr (std::is_aggregate_v<T>)
+            {
+                const auto & members = Refl::Members::get_member_functors<T>(0);
+                size_t count;
+                if (!F::readMap(in, count)) return "Expected map";
+                for (size_t i = 0; i < count; i++)
+                {
+                    bool found = false;
+                    const char * err = 0;
+                    if (F::isString(in))
+                    {
+                        const char * text; size_t len;
+                        if (!F::readString(in, text, len)) return "Invalid key";
+                        const ROString key(text, (int)len);
+                        std::apply([&](auto const & ... args)
+                            {
+                                ((!found && key == args.name() && (found = true) && (err = decode<F>(in, const_cast<std::remove_cvref_t<decltype(args.get(t))> &>(args.get(t)), depth + 1))), ...);
+                            }, members);
+                    }
+                    else
+                    {
+                        uint64 magnitude; bool negative;
+                        if (!F::readInteger(in, magnitude, negative)) return "Expected key";
+                        std::apply([&](auto const & ... args)
+                            {
+                                uint64 index = 0;
+                                ((!negative && index++ == magnitude && (found = true) && (err = decode<F>(in, const_cast<std::remove_cvref_t<decltype(args.get(t))> &>(args.get(t)), depth + 1))), ...);
+                            }, members);
+                    }
+                    if (err) return err;
+                    // Unknown members are skipped (unlike the JSON deserializer, which fails on them), so newer writers stay readable
+                    if (!found && !F::skip(in, depth + 1)) return "Invalid value";
+                }
+            }
+            else static_assert(Refl::always_false_v<T>, "Can't deserialize this type, views and pointers aren't supported (use RWString or std::string)");
+            return 0;
+        }
+    }
+
+    /** Serialize the given object to the given sink with the given format.
+        @return true if the sink was able to store the complete output */
+    template <typename F, class T, Tools::Sink S>
+    bool serialize(const T & obj, S & sink, const KeyMode keys = Names)
+    {
+        Details::encode<F>(sink, obj, keys);
+        return sink.isValid();
+    }
+
+    /** Serialize the given object with the given format in a new buffer.
+        @return The binary output (possibly containing zeros, so use its length) or an empty string on allocation failure */
+    template <typename F, class T>
+    RWString serialize(const T & obj, const KeyMode keys = Names)
+    {
+        Tools::DynamicSink sink;
+        Details::encode<F>(sink, obj, keys);
+        return sink.release();
+    }
+
+    /** Deserialize the given object from the given binary data with the given format.
+        Both key modes are accepted, and unknown members are skipped.
+        @return true on success, the error is logged on failure */
+    template <typename F, class T>
+    bool deserialize(T & obj, const ROString & data)
+    {
+        Reader in(data);
+        const char * err = Details::decode<F>(in, obj, 0);
+        if (!err && in.pos != in.len) err = "Unexpected data after the object";
+        if (!err) return true;
+        elogm(Log::Error | Log::Format, "Decoding error: %s@%d\n", err, (int)in.pos);
+        return false;
+    }
+}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef hpp_CBOR_hpp
+#define hpp_CBOR_hpp
+
+// We need the reflection based binary walker
+#include "BinarySerdes.hpp"
+#include <math.h>
+
+namespace Binary
+{
+    /** The CBOR format (RFC 8949).
+        Only definite lengths are produced and accepted. Floats are stored as single precision and doubles as double
+        precision. When decoding, half precision floats are accepted and tags are ignored when skipping. */
+    struct CBOR
+    {
+        enum MajorType { Unsigned = 0, Negative = 1, Bytes = 2, Text = 3, Array = 4, Map = 5, Tag = 6, Simple = 7 };
+
+        /** Write an item header with the given major type and argument */
+        template <Tools::Sink S>
+        static void writeHeader(S & out, const uint8 major, const uint64 v)
+        {
+            const char type = (char)(major << 5);
+            if (v < 24) out.put((char)(type | v));
+            else if (v <= 0xFF)       { out.put(type | 24); Details::writeBigEndian(out, v, 1); }
+            else if (v <= 0xFFFF)     { out.put(type | 25); Details::writeBigEndian(out, v, 2); }
+            else if (v <= 0xFFFFFFFF) { out.put(type | 26); Details::writeBigEndian(out, v, 4); }
+            else                      { out.put(type | 27); Details::writeBigEndian(out, v, 8); }
+        }
+        template <Tools::Sink S> static void writeUnsigned(S & out, const uint64 v)           { writeHeader(out, Unsigned, v); }
+        template <Tools::Sink S> static void writeNegative(S & out, const uint64 magnitude)   { writeHeader(out, Negative, magnitude); }
+        template <Tools::Sink S> static void writeBool(S & out, const bool b)                 { out.put((char)(b ? 0xF5 : 0xF4)); }
+        template <Tools::Sink S> static void writeFloat(S & out, const float f)               { uint32 v; memcpy(&v, &f, sizeof(v)); out.put((char)0xFA); Details::writeBigEndian(out, v, 4); }
+        template <Tools::Sink S> static void writeDouble(S & out, const double d)             { uint64 v; memcpy(&v, &d, sizeof(v)); out.put((char)0xFB); Details::writeBigEndian(out, v, 8); }
+        template <Tools::Sink S> static void writeString(S & out, const char * text, const size_t len) { writeHeader(out, Text, len); out.write(text, len); }
+        template <Tools::Sink S> static void writeArray(S & out, const size_t count)          { writeHeader(out, Array, count); }
+        template <Tools::Sink S> static void writeMap(S & out, const size_t count)            { writeHeader(out, Map, count); }
+
+        /** Read an item header. For simple values and floats, the argument is the raw value */
+        static bool readHeader(Reader & in, uint8 & major, uint64 & v)
+        {
+            uint8 b;
+            if (!in.byte(b)) return false;
+            major = b >> 5;
+            const uint8 info = b & 31;
+            if (info < 24) { v = info; return true; }
+            // Indefinite lengths and reserved values aren't supported
+            if (info > 27) return false;
+            return in.bigEndian((size_t)1 << (info - 24), v);
+        }
+        /** Read an item header of the given major type (nothing is consumed if the type doesn't match) */
+        static bool readExpected(Reader & in, const uint8 expected, uint64 & v)
+        {
+            uint8 major;
+            const size_t pos = in.pos;
+            if (readHeader(in, major, v) && major == expected) return true;
+            in.pos = pos;
+            return false;
+        }
+
+        /** Convert an half precision float to a double (from RFC 8949 appendix D) */
+        static double halfToDouble(const uint16 h)
+        {
+            const int e = (h >> 10) & 0x1F, m = h & 0x3FF;
+            double v = e == 0 ? ldexp(m, -24) : e != 31 ? ldexp(m + 1024, e - 25) : m ? NAN : INFINITY;
+            return h & 0x8000 ? -v : v;
+        }
+
+        static bool readInteger(Reader & in, uint64 & magnitude, bool & negative)
+        {
+            uint8 major;
+            const size_t pos = in.pos;
+            if (!readHeader(in, major, magnitude) || major > Negative) { in.pos = pos; return false; }
+            negative = major == Negative;
+            return true;
+        }
+        static bool readDouble(Reader & in, double & d)
+        {
+            uint8 b;
+            if (!in.peek(b)) return false;
+            if ((b >> 5) <= Negative)
+            {
+                uint64 magnitude; bool negative;
+                if (!readInteger(in, magnitude, negative)) return false;
+                d = negative ? -1.0 - (double)magnitude : (double)magnitude;
+                return true;
+            }
+            uint64 v;
+            if (b < 0xF9 || b > 0xFB || !readExpected(in, Simple, v)) return false;
+            if (b == 0xF9) d = halfToDouble((uint16)v);
+            else if (b == 0xFA) { float f; uint32 u = (uint32)v; memcpy(&f, &u, sizeof(f)); d = f; }
+            else memcpy(&d, &v, sizeof(d));
+            return true;
+        }
+        static bool readBool(Reader & in, bool & b)
+        {
+            uint8 c;
+            if (!in.peek(c) || (c != 0xF4 && c != 0xF5)) return false;
+            in.pos++; b = c == 0xF5;
+            return true;
+        }
+        static bool readString(Reader & in, const char *& text, size_t & len)
+        {
+            uint64 v;
+            const size_t pos = in.pos;
+            if (!readExpected(in, Text, v)) return false;
+            if (!in.bytes(v, text)) { in.pos = pos; return false; }
+            len = (size_t)v;
+            return true;
+        }
+        static bool readArray(Reader & in, size_t & count) { uint64 v; if (!readExpected(in, Array, v)) return false; count = (size_t)v; return true; }
+        static bool readMap(Reader & in, size_t & count)   { uint64 v; if (!readExpected(in, Map, v)) return false; count = (size_t)v; return true; }
+        static bool isString(const Reader & in)            { uint8 b; return in.peek(b) && (b >> 5) == Text; }
+
+        /** Skip the next item (and all its children) */
+        static bool skip(Reader & in, const size_t depth)
+        {
+            if (depth > MaxDepth) return false;
+            uint8 major; uint64 v; const char * p;
+            if (!readHeader(in, major, v)) return false;
+            switch (major)
+            {
+            case Bytes: case Text: return in.bytes(v, p);
+            case Array: for (uint64 i = 0; i < v; i++) if (!skip(in, depth + 1)) return false; return true;
+            case Map:   for (uint64 i = 0; i < v; i++) if (!skip(in, depth + 1) || !skip(in, depth + 1)) return false; return true;
+            case Tag:   return skip(in, depth + 1);
+            default:    return true;
+            }
+        }
+    };
+}
+
+/** Serialize the given object to CBOR in the given sink.
+    @param keys     Use Binary::Indices to store the member indices instead of their names
+    @return true if the sink was able to store the complete output */
+template <class T, Tools::Sink S>
+bool serializeCBOR(const T & obj, S & sink, const Binary::KeyMode keys = Binary::Names) { return Binary::serialize<Binary::CBOR>(obj, sink, keys); }
+
+/** Serialize the given object to CBOR.
+    @return The binary output (use its length, it can contain zeros) or an empty string on allocation failure */
+template <class T>
+RWString serializeCBOR(const T & obj, const Binary::KeyMode keys = Binary::Names) { return Binary::serialize<Binary::CBOR>(obj, keys); }
+
+/** Deserialize the given object from CBOR data. Members can be given by name or index. */
+template <class T>
+bool deserializeCBOR(T & obj, const ROString & data) { return Binary::deserialize<Binary::CBOR>(obj, data); }
+
+#endif
@@ -0,0 +1,316 @@
+#ifndef hpp_FlatLayout_hpp
+#define hpp_FlatLayout_hpp
+
+// We need the reflection based binary walker traits
+#include "BinarySerdes.hpp"
+// We need compile time strings to access members by name
+#include <array>
+#include "Strings/CTString.hpp"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+  #error "The flat layout is stored in little endian order and read in place, so it's only supported on little endian targets"
+#endif
+
+/** A fixed layout binary format, that's read in place without any parsing.
+
+    The layout is computed at compile time from the reflected type:
+    - a 8 bytes header with the schema hash and the total size of the buffer
+    - the fixed area of the root object, where each member has a fixed offset: numbers, enums and bools are stored as is,
+      char[N] are stored inline (N bytes), fixed arrays and nested aggregates are stored inline too
+    - the trailing area, where strings and vectors are stored. In the fixed area, they are replaced by an offset (from
+      the beginning of the buffer) and a length (in bytes for strings, in elements for vectors), both 32 bits.
+
+    Members are packed without padding, so they are read with memcpy. The schema hash is computed from the member
+    names and types, so a reader built with a different version of the structure refuses the buffer.
+
+    Reading a field from a received or mapped buffer is then only a bound check and a copy:
+    @code
+        auto view = openFlat<Record>(buffer);
+        if (view) { ROString name = view.get<"name">(); uint32 id = view.get<"id">(); }
+    @endcode */
+namespace Binary
+{
+    namespace Details
+    {
+        /** Size of the flat header */
+        static constexpr size_t FlatHeaderSize = 8;
+
+        template <typename T> constexpr bool is_flat_string_v = std::is_same_v<T, RWString> || std::is_same_v<T, ROString> || std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+        template <typename>                     struct IsVector : std::false_type { };
+        template <typename T, typename... Ts>   struct IsVector<std::vector<T, Ts...>> : std::true_type { };
+        template <typename T>                   constexpr bool is_vector_v = IsVector<T>::value;
+        /** The stored type: base64 byte containers are stored like the container they wrap */
+        template <typename T>                   struct FlatStored { using type = T; };
+        template <typename C>                   struct FlatStored<Base64Bytes<C>> { using type = C; };
+        template <typename T>                   using FlatStoredType = typename FlatStored<std::remove_cv_t<T>>::type;
+
+        /** The members tuple for an aggregate */
+        template <typename T> using FlatMembers = std::remove_cvref_t<decltype(Refl::Members::get_member_functors<T>(0))>;
+        template <typename T, size_t Ix> using FlatMemberType = typename std::tuple_element_t<Ix, FlatMembers<T>>::template type<>;
+
+        /** Compute the size of the given type in the fixed area */
+        template <typename U>
+        consteval size_t flatSize()
+        {
+            using T = FlatStoredType<U>;
+            if constexpr (std::is_enum_v<T> || std::is_arithmetic_v<T>) return sizeof(T);
+            else if constexpr (::Details::is_bounded_char_array_v<T>) return sizeof(T);
+            else if constexpr (is_flat_string_v<T> || is_vector_v<T>) return 2 * sizeof(uint32);
+            else if constexpr (std::is_array_v<T>) return std::extent_v<T> * flatSize<std::remove_extent_t<T>>();
+            else if constexpr (is_sequence_v<T>) return std::tuple_size_v<T> * flatSize<typename T::value_type>();
+            else if constexpr (std::is_aggregate_v<T>)
+                return []<size_t ... Ix>(std::index_sequence<Ix...>) { return (flatSize<FlatMemberType<T, Ix>>() + ... + 0); }(std::make_index_sequence<std::tuple_size_v<FlatMembers<T>>>{});
+            else
+            {
+                static_assert(Refl::always_false_v<T>, "This type can't be stored in a flat layout");
+                return 0;
+            }
+        }
+
+        /** Compute the offset of the given member in the fixed area of an aggregate */
+        template <typename T, size_t Ix>
+        consteval size_t flatOffset()
+        {
+            return []<size_t ... I>(std::index_sequence<I...>) { return (flatSize<FlatMemberType<T, I>>() + ... + 0); }(std::make_index_sequence<Ix>{});
+        }
+
+        /** Mix the given bytes in the hash (FNV-1a) */
+        consteval uint32 hashBytes(uint32 h, const char * s, const size_t len)
+        {
+            for (size_t i = 0; i < len; i++) h = (h ^ (uint8)s[i]) * 16777619u;
+            return h;
+        }
+        consteval uint32 hashValue(uint32 h, const char tag, const size_t v)
+        {
+            h = (h ^ (uint8)tag) * 16777619u;
+            for (size_t i = 0; i < sizeof(uint32); i++) h = (h ^ (uint8)(v >> (8 * i))) * 16777619u;
+            return h;
+        }
+
+        /** Compute the schema hash of the given type, from the member names and types */
+        template <typename U>
+        consteval uint32 flatHash(uint32 h)
+        {
+            using T = FlatStoredType<U>;
+            if constexpr (std::is_enum_v<T>) return hashValue(h, 'e', sizeof(T));
+            else if constexpr (std::is_same_v<T, bool>) return hashValue(h, 'b', 1);
+            else if constexpr (std::is_floating_point_v<T>) return hashValue(h, 'f', sizeof(T));
+            else if constexpr (std::is_integral_v<T>) return hashValue(h, std::is_signed_v<T> ? 'i' : 'u', sizeof(T));
+            else if constexpr (::Details::is_bounded_char_array_v<T>) return hashValue(h, 'c', sizeof(T));
+            else if constexpr (is_flat_string_v<T>) return hashValue(h, 's', 0);
+            else if constexpr (is_vector_v<T>) return flatHash<typename T::value_type>(hashValue(h, 'v', 0));
+            else if constexpr (std::is_array_v<T>) return flatHash<std::remove_extent_t<T>>(hashValue(h, 'a', std::extent_v<T>));
+            else if constexpr (is_sequence_v<T>) return flatHash<typename T::value_type>(hashValue(h, 'a', std::tuple_size_v<T>));
+            else
+            {
+                return hashValue([h]<size_t ... Ix>(std::index_sequence<Ix...>) consteval
+                {
+                    uint32 r = hashValue(h, '{', sizeof...(Ix));
+                    ((r = flatHash<FlatMemberType<T, Ix>>(hashBytes(r, std::tuple_element_t<Ix, FlatMembers<T>>::name().getData(), std::tuple_element_t<Ix, FlatMembers<T>>::name().getLength()))), ...);
+                    return r;
+                }(std::make_index_sequence<std::tuple_size_v<FlatMembers<T>>>{}), '}', 0);
+            }
+        }
+
+        /** Find the index of the member with the given name at compile time */
+        template <typename T, CompileTime::str Name>
+        consteval size_t flatIndexOf()
+        {
+            constexpr size_t len = CompileTime::strlen(Name.data);
+            return []<size_t ... Ix>(std::index_sequence<Ix...>)
+            {
+                size_t index = sizeof...(Ix);
+                ((std::tuple_element_t<Ix, FlatMembers<T>>::name().getLength() == len
+                  && !CompileTime::strncmp(std::tuple_element_t<Ix, FlatMembers<T>>::name().getData(), Name.data, (int)len) ? (index = Ix) : 0), ...);
+                return index;
+            }(std::make_index_sequence<std::tuple_size_v<FlatMembers<T>>>{});
+        }
+
+        /** Allocate the given size (zeroed) at the end of the buffer. @return the position of the allocated area */
+        inline size_t flatAppend(Tools::DynamicSink & buf, const size_t size)
+        {
+            const size_t pos = buf.length;
+            if (!buf.reserve(pos + size)) return pos;
+            memset(buf.buffer + pos, 0, size);
+            buf.length += size;
+            return pos;
+        }
+        /** Store the given bytes at the given position, if the buffer is still valid */
+        inline void flatStore(Tools::DynamicSink & buf, const size_t at, const void * data, const size_t size) { if (buf.isValid() && size) memcpy(buf.buffer + at, data, size); }
+        /** Store a reference (offset and length) in the fixed area */
+        inline void flatStoreRef(Tools::DynamicSink & buf, const size_t at, const size_t offset, const size_t length)
+        {
+            const uint32 ref[2] = { (uint32)offset, (uint32)length };
+            flatStore(buf, at, ref, sizeof(ref));
+        }
+
+        /** Write the given value at the given position of the fixed area (the trailing area is appended as needed) */
+        template <typename U>
+        void flatWrite(Tools::DynamicSink & buf, const size_t at, const U & t)
+        {
+            using T = FlatStoredType<U>;
+            if constexpr (std::is_enum_v<T> || std::is_arithmetic_v<T>) flatStore(buf, at, &t, sizeof(t));
+            else if constexpr (::Details::is_bounded_char_array_v<T>) flatStore(buf, at, t, strnlen(t, sizeof(t)));
+            else if constexpr (is_flat_string_v<T>)
+            {
+                const char * text; size_t len;
+                if constexpr (std::is_same_v<T, RWString> || std::is_same_v<T, ROString>) { text = t.getData(); len = t.getLength(); }
+                else { text = t.data(); len = t.length(); }
+                const size_t offset = flatAppend(buf, len);
+                flatStore(buf, offset, text, len);
+                flatStoreRef(buf, at, offset, len);
+            }
+            else if constexpr (is_vector_v<T>)
+            {
+                using E = typename T::value_type;
+                const size_t offset = flatAppend(buf, t.size() * flatSize<E>());
+                flatStoreRef(buf, at, offset, t.size());
+                for (size_t i = 0; i < t.size(); i++) flatWrite<E>(buf, offset + i * flatSize<E>(), t[i]);
+            }
+            else if constexpr (std::is_array_v<T> || is_sequence_v<T>)
+            {
+                using E = std::iter_value_t<decltype(std::begin(t))>;
+                for (size_t i = 0; i < std::size(t); i++) flatWrite<E>(buf, at + i * flatSize<E>(), t[i]);
+            }
+            else
+            {
+                [&]<size_t ... Ix>(std::index_sequence<Ix...>)
+                {
+                    (flatWrite<FlatMemberType<T, Ix>>(buf, at + flatOffset<T, Ix>(), std::tuple_element_t<Ix, FlatMembers<T>>::get(t)), ...);
+                }(std::make_index_sequence<std::tuple_size_v<FlatMembers<T>>>{});
+            }
+        }
+
+        /** A reference to the buffer being read */
+        struct FlatBuffer
+        {
+            const char * base;
+            size_t       size;
+
+            /** Get the reference (offset and length) stored at the given position, checking that the referenced area
+                (of the given element size) is in the buffer. An invalid reference is returned as an empty one */
+            void ref(const size_t at, const size_t elementSize, size_t & offset, size_t & length) const
+            {
+                uint32 r[2];
+                memcpy(r, base + at, sizeof(r));
+                offset = r[0]; length = r[1];
+                if (offset > size || (elementSize && length > (size - offset) / elementSize)) { offset = 0; length = 0; }
+            }
+        };
+    }
+
+    template <typename T> class FlatView;
+
+    /** A view on an array stored in a flat buffer */
+    template <typename E>
+    class FlatArray
+    {
+        Details::FlatBuffer buffer;
+        size_t              at, count;
+
+    public:
+        /** Get the number of elements */
+        size_t size() const { return count; }
+        /** Get the given element (no bound check is done here, the index must be lower than size()) */
+        auto operator[] (const size_t i) const { return FlatView<E>::read(buffer, at + i * Details::flatSize<E>()); }
+
+        FlatArray(const Details::FlatBuffer & buffer, const size_t at, const size_t count) : buffer(buffer), at(at), count(count) {}
+    };
+
+    /** A view on an aggregate stored in a flat buffer. Members are read in place, without parsing.
+        Numbers, enums and bools are returned by value, strings (and char arrays) as ROString pointing inside the buffer,
+        arrays and vectors as FlatArray and nested aggregates as FlatView */
+    template <typename T>
+    class FlatView
+    {
+        Details::FlatBuffer buffer;
+        size_t              at;
+
+        template <typename> friend class FlatArray;
+        template <typename> friend class FlatView;
+
+        /** Read any value at the given position */
+        static auto read(const Details::FlatBuffer & buffer, const size_t at)
+        {
+            using namespace Details;
+            using S = FlatStoredType<T>;
+            // A bool is read as a byte, since the buffer might not contain a valid bool representation
+            if constexpr (std::is_same_v<S, bool>) { uint8 v; memcpy(&v, buffer.base + at, sizeof(v)); return v != 0; }
+            else if constexpr (std::is_enum_v<S> || std::is_arithmetic_v<S>) { S v; memcpy(&v, buffer.base + at, sizeof(v)); return v; }
+            else if constexpr (::Details::is_bounded_char_array_v<S>) return ROString(buffer.base + at, (int)strnlen(buffer.base + at, sizeof(S)));
+            else if constexpr (is_flat_string_v<S>)
+            {
+                size_t offset, length;
+                buffer.ref(at, 1, offset, length);
+                return ROString(buffer.base + offset, (int)length);
+            }
+            else if constexpr (is_vector_v<S>)
+            {
+                using E = typename S::value_type;
+                size_t offset, length;
+                buffer.ref(at, flatSize<E>(), offset, length);
+                return FlatArray<E>(buffer, offset, length);
+            }
+            else if constexpr (std::is_array_v<S>) return FlatArray<std::remove_extent_t<S>>(buffer, at, std::extent_v<S>);
+            else if constexpr (is_sequence_v<S>) return FlatArray<typename S::value_type>(buffer, at, std::tuple_size_v<S>);
+            else return FlatView<T>(buffer, at);
+        }
+
+        FlatView(const Details::FlatBuffer & buffer, const size_t at) : buffer(buffer), at(at) {}
+
+    public:
+        /** Get the member with the given index */
+        template <size_t Ix>
+        auto get() const { return FlatView<Details::FlatMemberType<T, Ix>>::read(buffer, at + Details::flatOffset<T, Ix>()); }
+        /** Get the member with the given name */
+        template <CompileTime::str Name>
+        auto get() const
+        {
+            constexpr size_t Ix = Details::flatIndexOf<T, Name>();
+            static_assert(Ix < std::tuple_size_v<Details::FlatMembers<T>>, "No member with this name");
+            return get<Ix>();
+        }
+
+        /** Check if the view is valid (the buffer was accepted) */
+        explicit operator bool() const { return buffer.base != 0; }
+
+        /** Open a flat buffer. The buffer is checked for size and schema hash.
+            @return A view on the root object, that's invalid if the buffer was rejected */
+        static FlatView open(const ROString & data)
+        {
+            uint32 header[2] = {};
+            if (data.getLength() >= Details::FlatHeaderSize) memcpy(header, data.getData(), sizeof(header));
+            if (data.getLength() < Details::FlatHeaderSize + Details::flatSize<T>() || header[0] != Details::flatHash<T>(2166136261u) || header[1] > data.getLength())
+                return FlatView({0, 0}, 0);
+            return FlatView({data.getData(), header[1]}, Details::FlatHeaderSize);
+        }
+    };
+
+    /** Get the schema hash for the given type */
+    template <typename T>
+    consteval uint32 flatSchemaHash() { return Details::flatHash<T>(2166136261u); }
+}
+
+/** Serialize the given object to a flat buffer.
+    @return The flat buffer, or an empty string on allocation failure or if it's larger than 4GB
+    @sa Binary::FlatView */
+template <class T>
+RWString serializeFlat(const T & obj)
+{
+    using namespace Binary::Details;
+    Tools::DynamicSink buf(FlatHeaderSize + flatSize<T>());
+    flatAppend(buf, FlatHeaderSize + flatSize<T>());
+    flatWrite<T>(buf, FlatHeaderSize, obj);
+    if (buf.length > 0xFFFFFFFF) return RWString();
+    const uint32 header[2] = { Binary::flatSchemaHash<T>(), (uint32)buf.length };
+    flatStore(buf, 0, header, sizeof(header));
+    return buf.release();
+}
+
+/** Open a flat buffer for in place reading.
+    @warning The buffer must outlive the view (and any string read from it)
+    @return A view on the root object, check it with operator bool before use */
+template <class T>
+Binary::FlatView<T> openFlat(const ROString & data) { return Binary::FlatView<T>::open(data); }
+
+#endif
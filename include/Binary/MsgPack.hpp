@@ -0,0 +1,179 @@
+#ifndef hpp_MsgPack_hpp
+#define hpp_MsgPack_hpp
+
+// We need the reflection based binary walker
+#include "BinarySerdes.hpp"
+
+namespace Binary
+{
+    /** The MessagePack format.
+        Integers and lengths are always stored in their smallest representation. When skipping unknown members, binary
+        and extension types are accepted too. */
+    struct MsgPack
+    {
+        /** Write a type byte followed by a big endian value of the given size */
+        template <Tools::Sink S>
+        static void writeTyped(S & out, const uint8 type, const uint64 v, const size_t bytes) { out.put((char)type); Details::writeBigEndian(out, v, bytes); }
+
+        template <Tools::Sink S>
+        static void writeUnsigned(S & out, const uint64 v)
+        {
+            if (v < 0x80) out.put((char)v);
+            else if (v <= 0xFF)       writeTyped(out, 0xCC, v, 1);
+            else if (v <= 0xFFFF)     writeTyped(out, 0xCD, v, 2);
+            else if (v <= 0xFFFFFFFF) writeTyped(out, 0xCE, v, 4);
+            else                      writeTyped(out, 0xCF, v, 8);
+        }
+        template <Tools::Sink S>
+        static void writeNegative(S & out, const uint64 magnitude)
+        {
+            // The two's complement representation of the value, truncated by writeBigEndian as required
+            const uint64 v = (uint64)(-(int64)magnitude - 1);
+            if (magnitude < 32) out.put((char)v);
+            else if (magnitude < 0x80)       writeTyped(out, 0xD0, v, 1);
+            else if (magnitude < 0x8000)     writeTyped(out, 0xD1, v, 2);
+            else if (magnitude < 0x80000000) writeTyped(out, 0xD2, v, 4);
+            else                             writeTyped(out, 0xD3, v, 8);
+        }
+        template <Tools::Sink S> static void writeBool(S & out, const bool b)     { out.put((char)(b ? 0xC3 : 0xC2)); }
+        template <Tools::Sink S> static void writeFloat(S & out, const float f)   { uint32 v; memcpy(&v, &f, sizeof(v)); writeTyped(out, 0xCA, v, 4); }
+        template <Tools::Sink S> static void writeDouble(S & out, const double d) { uint64 v; memcpy(&v, &d, sizeof(v)); writeTyped(out, 0xCB, v, 8); }
+        template <Tools::Sink S>
+        static void writeString(S & out, const char * text, const size_t len)
+        {
+            if (len < 32) out.put((char)(0xA0 | len));
+            else if (len <= 0xFF)   writeTyped(out, 0xD9, len, 1);
+            else if (len <= 0xFFFF) writeTyped(out, 0xDA, len, 2);
+            else                    writeTyped(out, 0xDB, len, 4);
+            out.write(text, len);
+        }
+        template <Tools::Sink S>
+        static void writeArray(S & out, const size_t count)
+        {
+            if (count < 16) out.put((char)(0x90 | count));
+            else if (count <= 0xFFFF) writeTyped(out, 0xDC, count, 2);
+            else                      writeTyped(out, 0xDD, count, 4);
+        }
+        template <Tools::Sink S>
+        static void writeMap(S & out, const size_t count)
+        {
+            if (count < 16) out.put((char)(0x80 | count));
+            else if (count <= 0xFFFF) writeTyped(out, 0xDE, count, 2);
+            else                      writeTyped(out, 0xDF, count, 4);
+        }
+
+        /** Read a length for a type with a fixed variant (in the given range) and 8, 16 or 32 bits variants.
+            Absent variants are given as 0 */
+        static bool readLength(Reader & in, const uint8 fixFirst, const uint8 fixLast, const uint8 type8, const uint8 type16, const uint8 type32, uint64 & v)
+        {
+            uint8 b;
+            if (!in.peek(b)) return false;
+            if (b >= fixFirst && b <= fixLast) { in.pos++; v = b - fixFirst; return true; }
+            const size_t bytes = type8 && b == type8 ? 1 : b == type16 ? 2 : b == type32 ? 4 : 0;
+            if (!bytes) return false;
+            in.pos++;
+            if (in.bigEndian(bytes, v)) return true;
+            in.pos--;
+            return false;
+        }
+
+        static bool readInteger(Reader & in, uint64 & magnitude, bool & negative)
+        {
+            uint8 b;
+            if (!in.peek(b)) return false;
+            if (b < 0x80) { in.pos++; magnitude = b; negative = false; return true; }
+            if (b >= 0xE0) { in.pos++; magnitude = (uint64)(-1 - (int8)b); negative = true; return true; }
+            if (b < 0xCC || b > 0xD3) return false;
+            const size_t bytes = (size_t)1 << ((b - 0xCC) & 3);
+            uint64 v;
+            in.pos++;
+            if (!in.bigEndian(bytes, v)) { in.pos--; return false; }
+            if (b <= 0xCF) { magnitude = v; negative = false; return true; }
+            // Sign extend the value
+            const int64 s = bytes == 8 ? (int64)v : (int64)(v << (64 - 8 * bytes)) >> (64 - 8 * bytes);
+            negative = s < 0;
+            magnitude = negative ? (uint64)(-1 - s) : (uint64)s;
+            return true;
+        }
+        static bool readDouble(Reader & in, double & d)
+        {
+            uint8 b;
+            if (!in.peek(b)) return false;
+            if (b != 0xCA && b != 0xCB)
+            {
+                uint64 magnitude; bool negative;
+                if (!readInteger(in, magnitude, negative)) return false;
+                d = negative ? -1.0 - (double)magnitude : (double)magnitude;
+                return true;
+            }
+            uint64 v;
+            in.pos++;
+            if (!in.bigEndian(b == 0xCA ? 4 : 8, v)) { in.pos--; return false; }
+            if (b == 0xCA) { float f; uint32 u = (uint32)v; memcpy(&f, &u, sizeof(f)); d = f; }
+            else memcpy(&d, &v, sizeof(d));
+            return true;
+        }
+        static bool readBool(Reader & in, bool & b)
+        {
+            uint8 c;
+            if (!in.peek(c) || (c != 0xC2 && c != 0xC3)) return false;
+            in.pos++; b = c == 0xC3;
+            return true;
+        }
+        static bool readString(Reader & in, const char *& text, size_t & len)
+        {
+            uint64 v;
+            const size_t pos = in.pos;
+            if (!readLength(in, 0xA0, 0xBF, 0xD9, 0xDA, 0xDB, v)) return false;
+            if (!in.bytes(v, text)) { in.pos = pos; return false; }
+            len = (size_t)v;
+            return true;
+        }
+        static bool readArray(Reader & in, size_t & count) { uint64 v; if (!readLength(in, 0x90, 0x9F, 0, 0xDC, 0xDD, v)) return false; count = (size_t)v; return true; }
+        static bool readMap(Reader & in, size_t & count)   { uint64 v; if (!readLength(in, 0x80, 0x8F, 0, 0xDE, 0xDF, v)) return false; count = (size_t)v; return true; }
+        static bool isString(const Reader & in)            { uint8 b; return in.peek(b) && ((b >= 0xA0 && b <= 0xBF) || (b >= 0xD9 && b <= 0xDB)); }
+
+        /** Skip the next item (and all its children) */
+        static bool skip(Reader & in, const size_t depth)
+        {
+            if (depth > MaxDepth) return false;
+            uint8 b; uint64 v; size_t count; const char * p;
+            if (!in.peek(b)) return false;
+            if (b < 0x80 || b >= 0xE0 || b == 0xC0 || b == 0xC2 || b == 0xC3) { in.pos++; return true; }
+            if ((b >= 0xA0 && b <= 0xBF) || (b >= 0xD9 && b <= 0xDB)) { size_t len; return readString(in, p, len); }
+            if (readArray(in, count)) { for (size_t i = 0; i < count; i++) if (!skip(in, depth + 1)) return false; return true; }
+            if (readMap(in, count))   { for (size_t i = 0; i < count; i++) if (!skip(in, depth + 1) || !skip(in, depth + 1)) return false; return true; }
+            in.pos++;
+            switch (b)
+            {
+            case 0xC4: case 0xC5: case 0xC6: // Binary
+                return in.bigEndian((size_t)1 << (b - 0xC4), v) && in.bytes(v, p);
+            case 0xC7: case 0xC8: case 0xC9: // Extension (the type byte follows the length)
+                return in.bigEndian((size_t)1 << (b - 0xC7), v) && in.bytes(v + 1, p);
+            case 0xCA: case 0xCC: case 0xCD: case 0xCE: case 0xCF: case 0xD0: case 0xD1: case 0xD2: case 0xD3:
+                return in.bytes(b == 0xCA ? 4 : (uint64)1 << ((b - 0xCC) & 3), p);
+            case 0xCB: return in.bytes(8, p);
+            case 0xD4: case 0xD5: case 0xD6: case 0xD7: case 0xD8: // Fixed extension
+                return in.bytes(1 + ((uint64)1 << (b - 0xD4)), p);
+            default: return false;
+            }
+        }
+    };
+}
+
+/** Serialize the given object to MessagePack in the given sink.
+    @param keys     Use Binary::Indices to store the member indices instead of their names
+    @return true if the sink was able to store the complete output */
+template <class T, Tools::Sink S>
+bool serializeMsgPack(const T & obj, S & sink, const Binary::KeyMode keys = Binary::Names) { return Binary::serialize<Binary::MsgPack>(obj, sink, keys); }
+
+/** Serialize the given object to MessagePack.
+    @return The binary output (use its length, it can contain zeros) or an empty string on allocation failure */
+template <class T>
+RWString serializeMsgPack(const T & obj, const Binary::KeyMode keys = Binary::Names) { return Binary::serialize<Binary::MsgPack>(obj, keys); }
+
+/** Deserialize the given object from MessagePack data. Members can be given by name or index. */
+template <class T>
+bool deserializeMsgPack(T & obj, const ROString & data) { return Binary::deserialize<Binary::MsgPack>(obj, data); }
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef hpp_JSONNumber_hpp
+#define hpp_JSONNumber_hpp
+
+// We need read only strings
+#include "Strings/ROString.hpp"
+#include <string.h>
+#include <stdlib.h>
+#include <limits>
+#include <cmath>
+#include <type_traits>
+
+/** Type directed JSON number decoding.
+    Unlike a generic strtod based conversion, integers are decoded with an integer kernel (so 64 bits integers don't
+    lose precision) and overflow is detected. Doubles use an exact fast path when possible and only fall back to strtod
+    for long mantissa or large exponents. Nothing is allocated, so this is usable in heap free code. */
+namespace JSONNumber
+{
+    /** The result of a number decoding */
+    enum Result
+    {
+        Ok          = 0,    //!< The number was decoded
+        NotInteger  = 1,    //!< The number isn't an integer (or, for parseInteger, it's not written as one)
+        OutOfRange  = 2,    //!< The number doesn't fit the destination type
+        Invalid     = 3,    //!< The text isn't a valid number
+        TooLong     = 4,    //!< The text is too long to be converted without allocating (see Details::maxSlowPathLength)
+    };
+
+    namespace Details
+    {
+        /** Check if the 8 bytes in the given word are all ASCII digits */
+        inline bool isEightDigits(const uint64 w) { return (((w & 0xF0F0F0F0F0F0F0F0ULL) | (((w + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL); }
+        /** Convert 8 ASCII digits (loaded in a little endian word) to their value, without any branch or loop */
+        inline uint32 parseEightDigits(uint64 w)
+        {
+            w -= 0x3030303030303030ULL;
+            w = (w * 10) + (w >> 8);
+            return (uint32)((((w & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) + (((w >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32);
+        }
+
+        /** Accumulate the digits starting at the given position in the given accumulator, up to the given limit.
+            @return false on overflow */
+        inline bool accumulateDigits(const char * p, const size_t len, size_t & i, uint64 & acc, const uint64 limit)
+        {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            // Convert 8 digits at a time while it can't overflow
+            while (limit >= 99999999 && i + 8 <= len && acc <= (limit - 99999999) / 100000000)
+            {
+                uint64 w; memcpy(&w, p + i, sizeof(w));
+                if (!isEightDigits(w)) break;
+                acc = acc * 100000000 + parseEightDigits(w);
+                i += 8;
+            }
+#endif
+            for (; i < len; i++)
+            {
+                unsigned d = (unsigned)(p[i] - '0');
+                if (d > 9) break;
+                if (d > limit || acc > (limit - d) / 10) return false;
+                acc = acc * 10 + d;
+            }
+            return true;
+        }
+
+        /** The longest number text the strtod fallback accepts. It's copied on the stack to be zero terminated */
+        static constexpr size_t maxSlowPathLength = 127;
+
+        /** Exact powers of ten for the fast path */
+        static constexpr double powersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    }
+
+    /** Decode an integer from the given text.
+        @param text     The number text (as given by the parser)
+        @param out      On output, the decoded value if the result is Ok
+        @return Ok on success, NotInteger if the number has a fractional part or exponent, OutOfRange on overflow or Invalid */
+    template <typename T>
+    Result parseInteger(const ROString & text, T & out)
+    {
+        static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "Only integers are supported here");
+        const char * p = text.getData(); const size_t len = text.getLength();
+        size_t i = 0;
+        const bool neg = len && p[0] == '-';
+        if (neg) i++;
+        if (i == len || (unsigned)(p[i] - '0') > 9) return Invalid;
+
+        // The magnitude limit for the given sign
+        const uint64 limit = neg ? (std::is_signed_v<T> ? (uint64)std::numeric_limits<T>::max() + 1 : 0) : (uint64)std::numeric_limits<T>::max();
+        uint64 acc = 0;
+        if (!Details::accumulateDigits(p, len, i, acc, limit))
+        {   // Check if it's really an overflow or a syntax error
+            while (i < len && (unsigned)(p[i] - '0') <= 9) i++;
+            return i < len && (p[i] == '.' || p[i] == 'e' || p[i] == 'E') ? NotInteger : OutOfRange;
+        }
+        if (i < len) return p[i] == '.' || p[i] == 'e' || p[i] == 'E' ? NotInteger : Invalid;
+        if constexpr (std::is_signed_v<T>) out = neg ? (T)(0 - acc) : (T)acc;
+        else out = (T)acc;
+        return Ok;
+    }
+
+    /** Decode a double from the given text.
+        When the mantissa fits 53 bits and the decimal exponent is small, the conversion is exact with a single
+        multiplication or division (Clinger's fast path). Otherwise, this falls back to strtod, on a stack copy of the
+        text, so this never allocates.
+        @return Ok on success, TooLong if the fallback is required and the text is longer than maxSlowPathLength,
+                or Invalid */
+    inline Result parseDouble(const ROString & text, double & out)
+    {
+        const char * p = text.getData(); const size_t len = text.getLength();
+        size_t i = 0;
+        const bool neg = len && p[0] == '-';
+        if (neg) i++;
+        if (i == len || (unsigned)(p[i] - '0') > 9) return Invalid;
+
+        uint64 mantissa = 0; int exp10 = 0; bool exact = true;
+        size_t start = i;
+        if (!Details::accumulateDigits(p, len, i, mantissa, (1ULL << 53))) exact = false;
+        while (i < len && (unsigned)(p[i] - '0') <= 9) i++;
+        if (i < len && p[i] == '.')
+        {
+            start = ++i;
+            if (exact && !Details::accumulateDigits(p, len, i, mantissa, (1ULL << 53))) exact = false;
+            exp10 -= (int)(i - start);
+            while (i < len && (unsigned)(p[i] - '0') <= 9) i++;
+            if (i == start) return Invalid;
+        }
+        if (i < len && (p[i] == 'e' || p[i] == 'E'))
+        {
+            i++;
+            const bool negExp = i < len && p[i] == '-';
+            if (i < len && (p[i] == '-' || p[i] == '+')) i++;
+            if (i == len) return Invalid;
+            int e = 0;
+            for (; i < len && (unsigned)(p[i] - '0') <= 9; i++) if (e < 10000) e = e * 10 + (p[i] - '0');
+            exp10 += negExp ? -e : e;
+        }
+        if (i != len) return Invalid;
+
+        if (exact && exp10 >= -22 && exp10 <= 22)
+        {
+            double v = (double)mantissa;
+            v = exp10 < 0 ? v / Details::powersOfTen[-exp10] : v * Details::powersOfTen[exp10];
+            out = neg ? -v : v;
+            return Ok;
+        }
+        if (len > Details::maxSlowPathLength) return TooLong;
+        char buffer[Details::maxSlowPathLength + 1];
+        memcpy(buffer, p, len); buffer[len] = 0;
+        out = strtod(buffer, 0);
+        return Ok;
+    }
+
+    /** Decode a number to the given arithmetic type.
+        Integer types are decoded with the integer kernel. If the text has a fractional part or exponent, it's decoded
+        as a double and accepted only if its value is integral (like 1e3 or 2.0): a fraction is never truncated.
+        @return Ok on success, NotInteger if the value has a fraction and the destination type is an integer,
+                OutOfRange if the number doesn't fit the destination type, TooLong or Invalid */
+    template <typename T>
+    Result parse(const ROString & text, T & out)
+    {
+        if constexpr (std::is_integral_v<T>)
+        {
+            Result res = parseInteger(text, out);
+            if (res != NotInteger) return res;
+            double v;
+            if (Result res = parseDouble(text, v); res != Ok) return res;
+            if (v != std::trunc(v)) return NotInteger;
+            if (!(v > (double)std::numeric_limits<T>::min() - 1.0 && v < (double)std::numeric_limits<T>::max() + 1.0)) return OutOfRange;
+            out = static_cast<T>(v);
+            return Ok;
+        }
+        else
+        {
+            double v;
+            if (Result res = parseDouble(text, v); res != Ok) return res;
+            // JSON can't express infinity, so it's an overflow
+            if (std::isinf(v)) return OutOfRange;
+            if constexpr (sizeof(T) < sizeof(double))
+                if (v > (double)std::numeric_limits<T>::max() || v < -(double)std::numeric_limits<T>::max()) return OutOfRange;
+            out = static_cast<T>(v);
+            return Ok;
+        }
+    }
+}
+
+#endif
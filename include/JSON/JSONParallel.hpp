@@ -0,0 +1,269 @@
+#ifndef hpp_JSONParallel_hpp
+#define hpp_JSONParallel_hpp
+
+// We need the reflection based serializer and deserializer
+#include "JSONSerdes.hpp"
+// We need threads
+#include <thread>
+#include <atomic>
+#include <vector>
+
+/** Multithreaded deserialization and serialization of large batches.
+    This is meant for hosted (Linux) targets with many cores, it isn't used on embedded targets.
+    For deserialization, the text is first split in records with a structural pre-scan (which is a lot faster than
+    parsing), then the records are deserialized in parallel, each worker using its own parser, directly into their final
+    position in the output vector, so the order is preserved.
+    For serialization, each worker serializes a contiguous range of elements in its own buffer. */
+namespace Details
+{
+    /** A record in the text, as [start, end) positions */
+    struct RecordRange { size_t start, end; };
+
+    /** Split the top level JSON array in the given text into its element ranges.
+        @return false if the text isn't an array or it's not terminated */
+    inline bool splitArrayElements(const char * text, const size_t len, std::vector<RecordRange> & ranges)
+    {
+        size_t pos = JSONScan::skipWhitespace(text, len, 0);
+        if (pos == len || text[pos] != '[') return false;
+        ranges.reserve(JSONScan::countArrayElements(text, len, pos + 1));
+        pos = JSONScan::skipWhitespace(text, len, pos + 1);
+        if (pos < len && text[pos] == ']') return true;
+        while (pos < len)
+        {
+            size_t end = JSONScan::skipValue(text, len, pos);
+            if (end == pos || end >= len) return false;
+            ranges.push_back({pos, end});
+            pos = JSONScan::skipWhitespace(text, len, end);
+            if (pos < len && text[pos] == ']') return true;
+            if (pos >= len || text[pos] != ',') return false;
+            pos = JSONScan::skipWhitespace(text, len, pos + 1);
+        }
+        return false;
+    }
+
+    /** Split the given NDJSON text into its (non empty) lines */
+    inline void splitLines(const char * text, const size_t len, std::vector<RecordRange> & ranges, std::vector<size_t> & lines)
+    {
+        size_t line = 0;
+        for (size_t pos = 0; pos < len; line++)
+        {
+            const char * eol = (const char*)memchr(text + pos, '\n', len - pos);
+            const size_t end = eol ? (size_t)(eol - text) : len;
+            if (JSONScan::skipWhitespace(text, end, pos) != end) { ranges.push_back({pos, end}); lines.push_back(line); }
+            pos = end + 1;
+        }
+    }
+
+    /** Deserialize the given records in parallel.
+        Workers grab batches of consecutive records from a shared counter, so the load is balanced even when the
+        records don't have the same size.
+        @param out      The output vector, already sized to the number of records
+        @param errors   On output, the error for each record (empty on success)
+        @param threads  The number of workers to use, 0 for the number of hardware threads
+        @return true if all the records were deserialized */
+    template <typename T, typename P>
+    bool deserializeRecords(const char * text, const std::vector<RecordRange> & ranges, T * out, std::vector<RWString> & errors, size_t threads)
+    {
+        const size_t count = ranges.size();
+        errors.resize(count);
+        constexpr size_t batch = 64;
+        if (!threads) threads = max((size_t)std::thread::hardware_concurrency(), (size_t)1);
+        threads = min(threads, (count + batch - 1) / batch);
+
+        std::atomic<size_t> next(0);
+        std::atomic<bool> failed(false);
+        auto worker = [&]()
+        {
+            P parser(ROString(""));
+            for (size_t first = next.fetch_add(batch); first < count; first = next.fetch_add(batch))
+            {
+                for (size_t i = first; i < min(first + batch, count); i++)
+                {
+                    const ROString record(text + ranges[i].start, (int)(ranges[i].end - ranges[i].start));
+                    parser.reset(record);
+                    RWString err;
+                    if (parser.currentState() != P::JSON::EnteringObject && parser.currentState() != P::JSON::EnteringArray)
+                        err = "Expecting JSON object";
+                    else err = deserializeFromJSON(parser, out[i]);
+                    if (!err && JSONScan::skipWhitespace(record.getData(), record.getLength(), (size_t)parser.parser.pos) != record.getLength())
+                        err = "Unexpected data after the record";
+                    if (err) { errors[i] = err; failed = true; }
+                }
+            }
+        };
+
+        if (threads <= 1) worker();
+        else
+        {
+            std::vector<std::thread> pool;
+            pool.reserve(threads - 1);
+            for (size_t i = 1; i < threads; i++) pool.emplace_back(worker);
+            worker();
+            for (auto & th : pool) th.join();
+        }
+        return !failed;
+    }
+}
+
+/** Deserialize a large JSON array of objects using multiple threads.
+    The elements are split with a structural pre-scan and deserialized in parallel, in order, in the given vector.
+    @param obj      The vector to deserialize into. Its content is replaced
+    @param json     The JSON text, containing an array
+    @param threads  The number of threads to use, 0 for the number of hardware threads
+    @param P        The parser to use for each element (elements are parsed separately, so this only limits an element size)
+    @return true on success, false if the text isn't a valid array or any element fails to deserialize */
+template <class T, class P = Parser>
+bool deserializeParallel(std::vector<T> & obj, const ROString & json, const size_t threads = 0)
+{
+    std::vector<Details::RecordRange> ranges;
+    obj.clear();
+    if (!Details::splitArrayElements(json.getData(), json.getLength(), ranges))
+    {
+        elogm(Log::Error, "Parse error: Expecting a terminated JSON array\n");
+        return false;
+    }
+    obj.resize(ranges.size());
+    std::vector<RWString> errors;
+    if (Details::deserializeRecords<T, P>(json.getData(), ranges, obj.data(), errors, threads)) return true;
+    for (size_t i = 0; i < errors.size(); i++)
+        if (errors[i])
+        {
+            elogm(Log::Error | Log::Format, "Parse error in array element %d: %s\n", (int)i, (const char*)errors[i]);
+            break;
+        }
+    obj.clear();
+    return false;
+}
+
+/** Deserialize newline delimited JSON using multiple threads.
+    This is the parallel version of deserializeLines: the records that fail to deserialize are reported and skipped.
+    @param obj      The vector receiving the records, in order. Its content is replaced
+    @param json     The NDJSON text
+    @param onError  Called with the (zero based) line number and the error message of each failed record
+    @param threads  The number of threads to use, 0 for the number of hardware threads
+    @return The number of records deserialized
+    @sa deserializeLines */
+template <class T, class P = Parser>
+size_t deserializeLinesParallel(std::vector<T> & obj, const ROString & json, Tools::function_ref<void(size_t, ROString)> onError, const size_t threads = 0)
+{
+    std::vector<Details::RecordRange> ranges;
+    std::vector<size_t> lines;
+    Details::splitLines(json.getData(), json.getLength(), ranges, lines);
+    obj.clear();
+    obj.resize(ranges.size());
+    std::vector<RWString> errors;
+    if (Details::deserializeRecords<T, P>(json.getData(), ranges, obj.data(), errors, threads)) return obj.size();
+
+    // Report the errors in order and remove the failed records
+    size_t o = 0;
+    for (size_t i = 0; i < errors.size(); i++)
+    {
+        if (errors[i]) { onError(lines[i], errors[i]); continue; }
+        if (o != i) obj[o] = std::move(obj[i]);
+        o++;
+    }
+    obj.resize(o);
+    return o;
+}
+
+/** Deserialize newline delimited JSON using multiple threads, skipping the records that fail to deserialize.
+    @sa deserializeLinesParallel */
+template <class T, class P = Parser>
+size_t deserializeLinesParallel(std::vector<T> & obj, const ROString & json, const size_t threads = 0)
+{
+    return deserializeLinesParallel<T, P>(obj, json, [](size_t, ROString) {}, threads);
+}
+
+#if defined(AllowSerializing) && defined(AllowSerializingDynamicContainer)
+namespace Details
+{
+    /** Serialize the given array in contiguous chunks, in parallel.
+        Each chunk contains the separators preceding its elements, the first chunk starts with the opening bracket and
+        the last chunk ends with the closing bracket, so the concatenation of all chunks is the sequential output.
+        Elements are accessed by index, since std::vector<bool> doesn't have contiguous storage.
+        @return false if any chunk failed to allocate */
+    template <typename V>
+    bool serializeChunks(const V & elems, std::vector<RWString> & chunks, size_t threads)
+    {
+        const size_t count = elems.size();
+        // Don't bother splitting small arrays, the thread startup would cost more than the serialization
+        constexpr size_t minChunk = 256;
+        if (!threads) threads = max((size_t)std::thread::hardware_concurrency(), (size_t)1);
+        threads = max(min(threads, count / minChunk), (size_t)1);
+        chunks.clear();
+        chunks.resize(threads);
+
+        std::atomic<bool> failed(false);
+        auto worker = [&](const size_t k)
+        {
+            const size_t first = count * k / threads, last = count * (k + 1) / threads;
+            Tools::DynamicSink sink;
+            if (!k) sink.put('[');
+            for (size_t i = first; i < last; i++)
+            {
+                if (i) sink.put(',');
+                serializeToJSON(sink, elems[i]);
+            }
+            if (k == threads - 1) sink.put(']');
+            RWString part = sink.release();
+            if (!part) failed = true;
+            chunks[k].swapWith(part);
+        };
+
+        if (threads == 1) worker(0);
+        else
+        {
+            std::vector<std::thread> pool;
+            pool.reserve(threads - 1);
+            for (size_t k = 1; k < threads; k++) pool.emplace_back(worker, k);
+            worker(0);
+            for (auto & th : pool) th.join();
+        }
+        return !failed;
+    }
+}
+
+/** Serialize a large array using multiple threads.
+    Contiguous ranges of elements are serialized in per thread buffers, and they are concatenated once, since the total
+    size is known after the parallel phase. The output is identical to the sequential serialize function.
+    A byte array serialized as a base64 string (with JSONBytesAsBase64) is serialized sequentially.
+    @param obj      The array to serialize
+    @param threads  The number of threads to use, 0 for the number of hardware threads
+    @return The JSON text, or an empty string on allocation failure */
+template <class T>
+RWString serializeParallel(const std::vector<T> & obj, const size_t threads = 0)
+{
+    if constexpr (Details::is_base64_bytes_v<std::vector<T>>) return serialize(obj);
+    std::vector<RWString> chunks;
+    if (!Details::serializeChunks(obj, chunks, threads)) return RWString();
+    if (chunks.size() == 1) return std::move(chunks[0]);
+
+    size_t total = 0;
+    for (auto & chunk : chunks) total += chunk.getLength();
+    Tools::DynamicSink sink(total);
+    for (auto & chunk : chunks) sink.write(chunk.getData(), chunk.getLength());
+    return sink.release();
+}
+
+/** Serialize a large array using multiple threads, without concatenating the output.
+    The output is the concatenation of the returned chunks, in order. This is useful to send the output with a
+    scatter/gather call (like writev) without copying it again.
+    A byte array serialized as a base64 string (with JSONBytesAsBase64) is serialized sequentially, in a single chunk.
+    @param obj      The array to serialize
+    @param chunks   On output, the output chunks
+    @param threads  The number of threads to use, 0 for the number of hardware threads
+    @return false on allocation failure */
+template <class T>
+bool serializeParallel(const std::vector<T> & obj, std::vector<RWString> & chunks, const size_t threads = 0)
+{
+    if constexpr (Details::is_base64_bytes_v<std::vector<T>>)
+    {
+        chunks.clear();
+        chunks.push_back(serialize(obj));
+        return (bool)chunks[0];
+    }
+    return Details::serializeChunks(obj, chunks, threads);
+}
+#endif
+
+#endif
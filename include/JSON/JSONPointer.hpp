@@ -0,0 +1,190 @@
+#ifndef hpp_JSONPointer_hpp
+#define hpp_JSONPointer_hpp
+
+// We need the reflection based deserializer
+#include "JSONSerdes.hpp"
+
+/** Extraction of values with JSON pointers (RFC 6901), like "/config/wifi/ssid" or "/items/3/id".
+    Only the containers on the path are walked, all the other values are skipped with the structural scanner, and
+    only the targeted values are parsed. Many paths can be extracted in a single forward pass. */
+namespace JSONPointer
+{
+    /** A path to extract and where to store its value */
+    struct Target
+    {
+        /** The JSON pointer */
+        ROString    path;
+        /** The destination object */
+        void *      obj;
+        /** The function deserializing the value text to the destination object */
+        bool        (*assign)(void * obj, const ROString & value);
+        /** Set when the value was found and deserialized */
+        bool        found;
+    };
+
+    /** A typed target, as built by the at function */
+    template <typename T, typename P = Parser>
+    struct Path : public Target
+    {
+        static bool assignTo(void * obj, const ROString & value)
+        {
+            P parser(value);
+            RWString err = Details::deserializeFromJSON(parser, *(T*)obj);
+            if (err) return parser.Error(0, err);
+            return true;
+        }
+        Path(const ROString & path, T & out) : Target{path, &out, &assignTo, false} {}
+    };
+    /** Build a path to extract in the given object */
+    template <typename T, typename P = Parser>
+    Path<T, P> at(const ROString & path, T & out) { return Path<T, P>(path, out); }
+
+    namespace Details
+    {
+        /** Get the end of the reference token starting at the given position in the pointer */
+        inline size_t tokenEnd(const ROString & path, const size_t pos)
+        {
+            const char * end = (const char*)memchr(path.getData() + pos, '/', path.getLength() - pos);
+            return end ? (size_t)(end - path.getData()) : path.getLength();
+        }
+
+        /** Compare a reference token (where ~0 is ~ and ~1 is /) with a raw object key */
+        inline bool tokenEquals(const char * token, const size_t tokenLen, const char * key, const size_t keyLen)
+        {
+            if (!memchr(token, '~', tokenLen)) return tokenLen == keyLen && !memcmp(token, key, keyLen);
+            size_t k = 0;
+            for (size_t i = 0; i < tokenLen; i++, k++)
+            {
+                char c = token[i];
+                if (c == '~' && i + 1 < tokenLen) c = token[++i] == '1' ? '/' : '~';
+                if (k >= keyLen || key[k] != c) return false;
+            }
+            return k == keyLen;
+        }
+
+        /** Parse an array index reference token. @return false if it's not a valid index */
+        inline bool tokenIndex(const char * token, const size_t tokenLen, size_t & index)
+        {
+            if (!tokenLen || tokenLen > 18 || (token[0] == '0' && tokenLen > 1)) return false;
+            index = 0;
+            for (size_t i = 0; i < tokenLen; i++)
+            {
+                if ((unsigned)(token[i] - '0') > 9) return false;
+                index = index * 10 + (size_t)(token[i] - '0');
+            }
+            return true;
+        }
+
+        /** Walk the container at the given position, looking for the active targets.
+            The recursion only goes as deep as the longest pointer, and each level only uses a few words of stack.
+            @param active   The bitmask of the targets that are in this container
+            @param cursor   For each target, the position of the reference token to match at this level. It's shared by
+                            all levels: a target that matches is done at this level, so its cursor is moved in place to
+                            its next token before descending */
+        inline void walk(const char * data, const size_t len, size_t pos, Target * targets, uint64 active, size_t * cursor, const size_t depth)
+        {
+            if (depth > 64 || pos >= len || (data[pos] != '{' && data[pos] != '[')) return;
+            const bool isObject = data[pos] == '{';
+            const char close = isObject ? '}' : ']';
+            pos = JSONScan::skipWhitespace(data, len, pos + 1);
+            for (size_t index = 0; pos < len && data[pos] != close; index++)
+            {
+                const char * key = 0; size_t keyLen = 0;
+                if (isObject)
+                {
+                    if (data[pos] != '"') return;
+                    const size_t end = JSONScan::skipString(data, len, pos + 1);
+                    if (end >= len) return;
+                    key = data + pos + 1; keyLen = end - pos - 2;
+                    pos = JSONScan::skipWhitespace(data, len, end);
+                    if (pos >= len || data[pos] != ':') return;
+                    pos = JSONScan::skipWhitespace(data, len, pos + 1);
+                }
+
+                // Find the targets going through this value
+                uint64 matched = 0, descend = 0;
+                for (uint64 m = active; m; m &= m - 1)
+                {
+                    const size_t i = (size_t)__builtin_ctzll(m);
+                    const ROString & path = targets[i].path;
+                    const size_t end = tokenEnd(path, cursor[i]);
+                    const char * token = path.getData() + cursor[i];
+                    size_t tokenIx;
+                    if (isObject ? !tokenEquals(token, end - cursor[i], key, keyLen) : !tokenIndex(token, end - cursor[i], tokenIx) || tokenIx != index) continue;
+                    matched |= (uint64)1 << i;
+                    if (end == path.getLength())
+                    {
+                        const size_t valueEnd = JSONScan::skipValue(data, len, pos);
+                        targets[i].found = targets[i].assign(targets[i].obj, ROString(data + pos, (int)(valueEnd - pos)));
+                    }
+                    else { descend |= (uint64)1 << i; cursor[i] = end + 1; }
+                }
+                if (descend) walk(data, len, pos, targets, descend, cursor, depth + 1);
+                // A key (or index) appears once, so the matched targets are done at this level
+                active &= ~matched;
+                if (!active) return;
+
+                pos = JSONScan::skipWhitespace(data, len, JSONScan::skipValue(data, len, pos));
+                if (pos < len && data[pos] == ',') pos = JSONScan::skipWhitespace(data, len, pos + 1);
+            }
+        }
+    }
+
+    /** Extract all the given targets in a single forward pass.
+        @param targets  The targets to extract (up to 64)
+        @return The number of targets that were found and deserialized */
+    inline size_t extract(const ROString & json, Target * targets, const size_t count)
+    {
+        const char * data = json.getData();
+        const size_t len = json.getLength(), root = JSONScan::skipWhitespace(data, len, 0);
+        uint64 active = 0;
+        size_t cursor[64];
+        for (size_t i = 0; i < count && i < 64; i++)
+        {
+            const ROString & path = targets[i].path;
+            targets[i].found = false;
+            // The empty pointer is the complete document
+            if (!path.getLength()) targets[i].found = targets[i].assign(targets[i].obj, json);
+            else if (path.getData()[0] == '/') { active |= (uint64)1 << i; cursor[i] = 1; }
+        }
+        if (active) Details::walk(data, len, root, targets, active, cursor, 0);
+
+        size_t found = 0;
+        for (size_t i = 0; i < count; i++) found += targets[i].found;
+        return found;
+    }
+}
+
+/** Extract a single value from a JSON document with a JSON pointer, without deserializing the complete document.
+    For example:
+    @code
+        RWString ssid;
+        extract(json, "/config/wifi/ssid", ssid);
+    @endcode
+    @param json     The JSON text
+    @param path     The JSON pointer to the value (RFC 6901), like "/items/3/id"
+    @param out      The object to deserialize the value into (any type supported by deserialize)
+    @return true if the value was found and deserialized */
+template <class T, class P = Parser>
+bool extract(const ROString & json, const ROString & path, T & out)
+{
+    JSONPointer::Path<T, P> target(path, out);
+    return JSONPointer::extract(json, &target, 1) == 1;
+}
+
+/** Extract many values from a JSON document in a single forward pass.
+    For example:
+    @code
+        RWString ssid; int id;
+        extract(json, JSONPointer::at("/config/wifi/ssid", ssid), JSONPointer::at("/items/3/id", id));
+    @endcode
+    @return The number of values that were found and deserialized */
+template <class ... T, class ... P>
+size_t extract(const ROString & json, JSONPointer::Path<T, P> ... paths)
+{
+    static_assert(sizeof...(T) <= 64, "Too many paths to extract at once");
+    JSONPointer::Target targets[] = { paths... };
+    return JSONPointer::extract(json, targets, sizeof...(T));
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef hpp_JSONSAX_hpp
+#define hpp_JSONSAX_hpp
+
+// We need the parser
+#include "JSONSerdes.hpp"
+
+/** Event based (SAX) interface to the JSON parser.
+    The parser's token stream is forwarded to a handler without building any object, so documents are processed in
+    constant memory (the parser only stores its nesting stack) and at the parser's speed. This is useful for consumers
+    that transform or aggregate the data and don't need a struct.
+
+    A handler is any type with these methods (each returning false stops the parsing):
+    @code
+        bool onKey(const ROString & key);
+        bool onString(const ROString & text);
+        bool onNumber(const ROString & text);
+        bool onBool(const bool value);
+        bool onNull();
+        bool onStartObject(); bool onEndObject();
+        bool onStartArray();  bool onEndArray();
+    @endcode
+    Derive from SAX::Handler to only implement the events you're interested in. Since the handler type is known at
+    compile time, the calls are inlined.
+    Keys and strings are given as they are in the text (escape sequences are kept, use Details::unescapeJSON to decode
+    them) and numbers are given as text (use JSONNumber::parse to decode them). */
+namespace SAX
+{
+    /** A handler ignoring all events. Derive from it and hide the methods you need */
+    struct Handler
+    {
+        bool onKey(const ROString &)    { return true; }
+        bool onString(const ROString &) { return true; }
+        bool onNumber(const ROString &) { return true; }
+        bool onBool(const bool)         { return true; }
+        bool onNull()                   { return true; }
+        bool onStartObject()            { return true; }
+        bool onEndObject()              { return true; }
+        bool onStartArray()             { return true; }
+        bool onEndArray()               { return true; }
+    };
+
+    /** The events, for the callback interface */
+    enum Event
+    {
+        Key = 0,
+        String,
+        Number,
+        Bool,       //!< The text is either "true" or "false"
+        Null,
+        StartObject,
+        EndObject,
+        StartArray,
+        EndArray,
+    };
+
+    /** A handler forwarding all the events to a single callback */
+    struct Dispatcher
+    {
+        Tools::function_ref<bool(Event, const ROString &)> callback;
+
+        bool onKey(const ROString & key)    { return callback(Key, key); }
+        bool onString(const ROString & text){ return callback(String, text); }
+        bool onNumber(const ROString & text){ return callback(Number, text); }
+        bool onBool(const bool value)       { return callback(Bool, value ? "true" : "false"); }
+        bool onNull()                       { return callback(Null, ROString()); }
+        bool onStartObject()                { return callback(StartObject, ROString()); }
+        bool onEndObject()                  { return callback(EndObject, ROString()); }
+        bool onStartArray()                 { return callback(StartArray, ROString()); }
+        bool onEndArray()                   { return callback(EndArray, ROString()); }
+    };
+
+    namespace Details
+    {
+        /** Forward the current token to the handler. @return false if the handler stopped or the token is invalid */
+        template <typename P, typename H>
+        bool dispatch(P & parser, H & handler)
+        {
+            switch (parser.currentState())
+            {
+            case P::JSON::EnteringObject: return handler.onStartObject();
+            case P::JSON::LeavingObject:  return handler.onEndObject();
+            case P::JSON::EnteringArray:  return handler.onStartArray();
+            case P::JSON::LeavingArray:   return handler.onEndArray();
+            case P::JSON::HadKey:         return handler.onKey(parser.current());
+            case P::JSON::HadValue:
+                switch (parser.token.type)
+                {
+                case P::JSON::Token::String:  return handler.onString(parser.current());
+                case P::JSON::Token::Number:  return handler.onNumber(parser.current());
+                case P::JSON::Token::True:    return handler.onBool(true);
+                case P::JSON::Token::False:   return handler.onBool(false);
+                case P::JSON::Token::Null:    return handler.onNull();
+                default: return parser.Error(P::JSON::Invalid);
+                }
+            default: return parser.Error(P::JSON::Invalid);
+            }
+        }
+    }
+}
+
+/** Parse the given JSON text and forward all its tokens to the given handler.
+    @param json     The JSON text
+    @param handler  The handler (see SAX namespace for the expected interface)
+    @return true if the complete document was parsed, false on parse error (it's logged) or if the handler stopped */
+template <typename H, typename P = Parser>
+    requires(!std::is_invocable_v<H, SAX::Event, const ROString &>)
+bool parseSAX(const ROString & json, H & handler)
+{
+    P parser(json);
+    if (parser.errorPos != P::JSON::InvalidPos) return false;
+    do
+    {
+        if (!SAX::Details::dispatch(parser, handler)) return false;
+    } while (parser.parseNext());
+    return parser.errorPos == P::JSON::InvalidPos;
+}
+
+/** Parse the given JSON text and call the given callback for each token.
+    For example, to sum all the numbers in a document:
+    @code
+        double sum = 0;
+        parseSAX(json, [&](SAX::Event ev, const ROString & text) { if (ev == SAX::Number) sum += (double)text; return true; });
+    @endcode
+    @return true if the complete document was parsed, false on parse error (it's logged) or if the callback stopped */
+template <typename P = Parser>
+bool parseSAX(const ROString & json, Tools::function_ref<bool(SAX::Event, const ROString &)> callback)
+{
+    SAX::Dispatcher dispatcher{callback};
+    return parseSAX<SAX::Dispatcher, P>(json, dispatcher);
+}
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef hpp_JSONScan_hpp
+#define hpp_JSONScan_hpp
+
+// We need read only strings
+#include "Strings/ROString.hpp"
+// We need vectorized search
+#include "Tools/ByteScan.hpp"
+
+/** Structural scanning of JSON text.
+    These functions don't validate or parse the JSON text, they only follow its structure (strings and nesting) to skip
+    over values or count them. This is a lot faster than the parser since uninteresting bytes are skipped with
+    a vectorized search. They are used to pre-size containers, split large documents or skip unwanted values. */
+namespace JSONScan
+{
+    /** Skip whitespace starting at the given position. @return the position of the first non whitespace char */
+    inline size_t skipWhitespace(const char * data, const size_t len, size_t pos)
+    {
+        while (pos < len && (data[pos] == ' ' || data[pos] == '\t' || data[pos] == '\n' || data[pos] == '\r')) pos++;
+        return pos;
+    }
+
+    /** Skip a string.
+        @param pos  The position right after the opening quote
+        @return the position right after the closing quote, or len if the string isn't terminated */
+    inline size_t skipString(const char * data, const size_t len, size_t pos)
+    {
+        while (pos < len)
+        {
+            pos += Tools::findFirstOf<0, '"', '\\'>(data + pos, len - pos);
+            if (pos >= len) break;
+            if (data[pos] == '"') return pos + 1;
+            pos += 2; // Escaped char
+        }
+        return len;
+    }
+
+    /** Find the end of the container whose content starts at the given position.
+        @param pos      The position right after the opening bracket or brace
+        @param commas   If not null, receives the number of commas found at the container level
+        @return the position of the closing bracket or brace, or len if the container isn't terminated */
+    inline size_t findContainerEnd(const char * data, const size_t len, size_t pos, size_t * commas = 0)
+    {
+        size_t depth = 0, count = 0;
+        while (pos < len)
+        {
+            pos += Tools::findFirstOf<0, '"', '[', ']', '{', '}', ','>(data + pos, len - pos);
+            if (pos >= len) break;
+            switch (data[pos])
+            {
+            case '"': pos = skipString(data, len, pos + 1); continue;
+            case '[': case '{': depth++; break;
+            case ']': case '}': if (!depth) { if (commas) *commas = count; return pos; } depth--; break;
+            case ',': if (!depth) count++; break;
+            }
+            pos++;
+        }
+        if (commas) *commas = count;
+        return len;
+    }
+
+    /** Skip a complete value (string, number, literal, array or object).
+        @param pos  The position of the first char of the value (whitespace is skipped)
+        @return the position right after the value */
+    inline size_t skipValue(const char * data, const size_t len, size_t pos)
+    {
+        pos = skipWhitespace(data, len, pos);
+        if (pos >= len) return len;
+        switch (data[pos])
+        {
+        case '"': return skipString(data, len, pos + 1);
+        case '[': case '{': { size_t end = findContainerEnd(data, len, pos + 1); return end < len ? end + 1 : len; }
+        default:
+            // Number or literal, up to the next structural char or whitespace
+            while (pos < len && !strchr(",]} \t\r\n", data[pos])) pos++;
+            return pos;
+        }
+    }
+
+    /** Find the value of the given key in the object whose content starts at the given position.
+        Only the keys of this object are searched, nested objects are skipped. Keys are compared without unescaping.
+        @param pos  The position right after the opening brace
+        @return the position of the first char of the value, or len if not found */
+    inline size_t findObjectKey(const char * data, const size_t len, size_t pos, const ROString & key)
+    {
+        while (true)
+        {
+            pos = skipWhitespace(data, len, pos);
+            if (pos >= len || data[pos] != '"') return len;
+            const size_t start = pos + 1;
+            pos = skipString(data, len, start);
+            const bool match = pos < len && pos - 1 - start == key.getLength() && !memcmp(data + start, key.getData(), key.getLength());
+            pos = skipWhitespace(data, len, pos);
+            if (pos >= len || data[pos] != ':') return len;
+            pos = skipWhitespace(data, len, pos + 1);
+            if (match) return pos;
+            pos = skipWhitespace(data, len, skipValue(data, len, pos));
+            if (pos >= len || data[pos] != ',') return len;
+            pos++;
+        }
+    }
+
+    /** Count the number of elements in the array whose content starts at the given position.
+        @param pos  The position right after the opening bracket
+        @return the number of elements in the array */
+    inline size_t countArrayElements(const char * data, const size_t len, size_t pos)
+    {
+        pos = skipWhitespace(data, len, pos);
+        if (pos >= len || data[pos] == ']') return 0;
+        size_t commas = 0;
+        findContainerEnd(data, len, pos, &commas);
+        return commas + 1;
+    }
+}
+
+#endif
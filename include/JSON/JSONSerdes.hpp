@@ -8,15 +8,42 @@
 #include "JSON.hpp"
 // We need logs too for error reporting
 #include <stdlib.h>
+// We need span for fixed buffer serialization
+#include <span>
+#include <new>
+#include <variant>
+#include <vector>
+#include <charconv>
+#include <iterator>
 // We need automated struct parsing
 #include "Reflection/AutoEnum.hpp"
 #include "Reflection/AutoStruct.hpp"
+// We need output sinks for serializing
+#include "Tools/Sinks.hpp"
+// We need vectorized search for escaping
+#include "Tools/ByteScan.hpp"
+// We need an arena for borrowed deserialization
+#include "Tools/Arena.hpp"
+// We need structural scanning for pre-sizing containers
+#include "JSONScan.hpp"
+// We need type directed number decoding
+#include "JSONNumber.hpp"
+// We need base64 for byte containers
+#include "Tools/Base64.hpp"
 
 
 // Allow serializing and deserializing std::vector or std::array
 #define AllowSerializingDynamicContainer 1
 // Add code for serialization (and the serialize function too)
 #define AllowSerializing                 1
+// Serialize all byte containers (uint8[N], std::array<uint8, N> and std::vector<uint8>) as base64 strings instead of
+// arrays of numbers. Without it, use Base64Bytes for the members that should be encoded this way
+// #define JSONBytesAsBase64             1
+// The number of significant digits used when serializing numbers. The default is the same as printf's %g.
+// Set it to 0 to output the shortest text that reads back to the exact same value (and integers without rounding)
+#ifndef JSONFloatPrecision
+  #define JSONFloatPrecision             6
+#endif
 
 /** This file contains a magic JSON deserializer and serializer based on C++ reflection.
 
@@ -45,14 +72,14 @@
 
 
         A a;
-        const char* text = R"({"i":-45.2, "f": 3.14, "d": 2.71, "b": true, "text": "hello world!" })";
+        const char* text = R"({"i":-45, "f": 3.14, "d": 2.71, "b": true, "text": "hello world!" })";
         if (!deserialize(a, text))
             std::cerr << "Error deserializing text" << text << std::endl;
         dump(a); // Outputs: i = -45, f = 3.14, d = 2.71, b = true, text = "hello world!"
         printf(serialize(a)); // Outputs: {"i":-45,"f":3.14,"d":2.71,"b":true,"text":"hello world!"}
 
         B b;
-        const char* text2 = R"({"name":"Time to market", "series": [3.14, 1.23, 3.45, 5.67, 7.89] })";
+        const char* text2 = R"({"name":"Time to market", "series": [3, 1, 3, 5, 7] })";
         if (!deserialize(b, text2))
             std::cerr << "Error deserializing text2" << text2 << std::endl;
         printf(serialize(b)); // Outputs: {"series":[3,1,3,5,7],"name":"Time to market"}
@@ -85,6 +112,52 @@
 
 
 
+/** A byte container (std::array<uint8, N> or std::vector<uint8>) that's serialized as a base64 string instead of an
+    array of numbers. This is a lot more compact and faster for binary data (images, firmware chunks, raw frames).
+    For example:
+    @code
+        struct Frame { int id; Base64Bytes<std::vector<uint8>> payload; };
+    @endcode
+    It's the container itself, so it's used like it. A fixed size container must be completely filled when decoding */
+template <typename C>
+struct Base64Bytes : public C
+{
+    static_assert(sizeof(typename C::value_type) == 1 && std::is_integral_v<typename C::value_type>, "Base64Bytes only works on byte containers (like std::vector<uint8> or std::array<uint8, N>)");
+
+    using C::operator=;
+    /** Assign from the underlying container */
+    Base64Bytes & operator=(const C & other) { C::operator=(other); return *this; }
+    /** Assign from a list of bytes, like: bytes = {1, 2, 3}.
+        Without it, this is ambiguous for a std::array, since the list can build either the container or this type.
+        A std::array is zero filled after the given bytes */
+    Base64Bytes & operator=(std::initializer_list<typename C::value_type> bytes)
+    {
+        C other{};
+        if constexpr (requires { other.assign(bytes); }) other.assign(bytes);
+        else
+        {
+            size_t i = 0;
+            for (auto b : bytes) if (i < std::size(other)) other[i++] = b;
+        }
+        return *this = other;
+    }
+};
+
+/** A string whose text is stored in the arena given to deserialize, instead of the heap.
+    The text is copied (and unescaped), so the source buffer can be released, but the arena must outlive the string.
+    @sa deserialize(T &, const ROString &, Tools::BumpArena &) */
+struct ArenaString : public ROString
+{
+    using ROString::ROString;
+    using ROString::operator=;
+    ArenaString(const ROString & other) : ROString(other) {}
+};
+
+/** A vector whose storage is allocated in the arena given to deserialize, instead of the heap.
+    @sa deserialize(T &, const ROString &, Tools::BumpArena &) */
+template <typename T>
+using ArenaVector = std::vector<T, Tools::ArenaAllocator<T>>;
+
 /** A very simple LIFO class, with fixed size depth, no dynamic allocation */
 template <typename T, size_t count>
 struct LIFO
@@ -100,27 +173,41 @@ struct LIFO
     LIFO() : top(0) {}
 };
 
-/** The main parser object that's implementing the logic for extracting keys from simple objects */
-struct Parser
+/** The main parser object that's implementing the logic for extracting keys from simple objects
+    @param Index      The type used to store positions in the JSON text. This limits the maximum size of the text
+                      (32767 bytes for int16)
+    @param MaxDepth   The maximum nesting depth of the JSON text
+    @param Borrowed   If true, ROString and std::string_view members are allowed and point inside the source buffer.
+                      This is a compile time property, so deserializing a view with a regular parser doesn't compile
+    @sa Parser for the compact version and WideParser for large documents */
+template <typename Index = int16, size_t MaxDepth = 64, bool Borrowed = false>
+struct ParserT
 {
-    typedef JSONT<int16> JSON;
-
-
-    const ROString & data;
-    JSON             parser;
-    JSON::Token      token;
-    LIFO<int16, 64>  superPos;
-    int16            lastSuper;
-    int16            errorPos;
+    typedef JSONT<Index> JSON;
+    /** The same parser, in borrowed mode */
+    typedef ParserT<Index, MaxDepth, true> BorrowingParser;
+
+
+    /** The JSON text (this is a view on the caller's buffer) */
+    ROString                data;
+    JSON                    parser;
+    typename JSON::Token    token;
+    LIFO<Index, MaxDepth>   superPos;
+    Index                   lastSuper;
+    Index                   errorPos;
+    /** In borrowed mode, ROString and std::string_view members are allowed and point inside the source buffer */
+    static constexpr bool   borrowed = Borrowed;
+    /** The scratch arena used to store unescaped strings in borrowed mode (can be null) */
+    Tools::BumpArena * scratch;
 
     ROString current() const { return data.midString(token.start, token.end - token.start); }
 
-    bool Error(JSON::IndexType res, const char * err = NULL) {
+    bool Error(typename JSON::IndexType res, const char * err = NULL) {
         errorPos = parser.pos;
-        size_t start = (size_t)std::max(errorPos - 16, 0), end = std::min(start + 32, data.getLength());
-        size_t prev = (size_t)std::min((int)errorPos, 16);
+        size_t start = (size_t)std::max((int32)errorPos - 16, (int32)0), end = std::min(start + 32, data.getLength());
+        size_t prev = (size_t)std::min((int32)errorPos, (int32)16);
 
-        const char* resName = res ? Refl::enum_value_name((JSON::ParsingResult)res) : "";
+        const char* resName = res ? Refl::enum_value_name((typename JSON::ParsingResult)res) : "";
         if (!err) err = resName;
         elogm(Log::Error | Log::Format, "Parse error: %s@%d: %.*s > HERE < %.*s\"\n", err, errorPos, (int)prev, data.getData() + start, (int)((end - start) - prev), data.getData()+start + prev);
 
@@ -131,7 +218,7 @@ struct Parser
     {
         if (parser.state == JSON::Done) return false;
 
-        JSON::IndexType res = parser.parseOne(data.getData(), data.getLength(), token, lastSuper);
+        typename JSON::IndexType res = parser.parseOne(data.getData(), data.getLength(), token, lastSuper);
         if (res < 0) return Error(res);
 
         if (res == JSON::SaveSuper)
@@ -139,7 +226,7 @@ struct Parser
         if (res == JSON::RestoreSuper) {
             // Need to consume the last value anyway, it's useless
             if (superPos.size()) superPos.pop();
-            lastSuper = superPos.size() ? superPos.peek() : (JSON::IndexType)JSON::InvalidPos;
+            lastSuper = superPos.size() ? superPos.peek() : (typename JSON::IndexType)JSON::InvalidPos;
         }
         if (res == JSON::Finished) {
             // We are done.
@@ -174,27 +261,55 @@ struct Parser
     double getDouble()  { return token.type == JSON::Token::Number ? (double)current() : 0.0; }
     int getInt()        { return token.type == JSON::Token::Number ? (int)current() : 0; }
 
-    JSON::SAXState currentState() const { return (JSON::SAXState)token.state; }
+    typename JSON::SAXState currentState() const { return (typename JSON::SAXState)token.state; }
 
-    Parser(const ROString & in) : data(in), lastSuper(JSON::InvalidPos), errorPos(JSON::InvalidPos)
+    /** Start parsing the current text */
+    void start()
     {
+        // Positions wouldn't fit the index type, so refuse to parse instead of wrapping around
+        if (data.getLength() > (size_t)std::numeric_limits<Index>::max())
+        {
+            parser.state = JSON::Done;
+            Error(0, "Document too large for this parser, use a WideParser");
+            return;
+        }
         parseNext();
     }
+
+    /** Restart parsing with a new text. This is used to reuse the same parser for many small documents */
+    void reset(const ROString & in)
+    {
+        new (&data) ROString(in);
+        parser = JSON(); token = typename JSON::Token(); superPos.top = 0;
+        lastSuper = JSON::InvalidPos; errorPos = JSON::InvalidPos;
+        start();
+    }
+
+    ParserT(const ROString & in) : data(in), lastSuper(JSON::InvalidPos), errorPos(JSON::InvalidPos), scratch(0)
+    {
+        start();
+    }
 };
 
+/** The default parser, with a compact footprint suitable for embedded targets (up to 32KB documents, 64 levels deep) */
+typedef ParserT<int16, 64> Parser;
+/** The parser for large documents (up to 2GB, 256 levels deep) */
+typedef ParserT<int32, 256> WideParser;
+
 namespace Details
 {
-    // You must specialize this function for non supported types
-    template <typename U> RWString deserializeFromJSON(Parser & json, U & t, const bool allowPartial = false);
+    // You must specialize this function for non supported types.
+    // The error type E is either RWString or const char * (static messages only, so the failure path doesn't allocate either)
+    template <typename E = RWString, typename P, typename U> E deserializeFromJSON(P & json, U & t, const bool allowPartial = false);
 
 
-    template <typename T, typename ... Members>
-    bool deserializeField(Parser & parser, RWString & err, const ROString & key, T & instance, std::tuple<Members...> const & tup)
+    template <typename E, typename P, typename T, typename ... Members>
+    bool deserializeField(P & parser, E & err, const ROString & key, T & instance, std::tuple<Members...> const & tup)
     {
         bool found = false;
         std::apply([&found, &parser, &key, &err, &instance](Members const &... args)
             {
-                ((key == args.name() && (found = true) && (err = deserializeFromJSON(parser, const_cast<std::remove_cvref_t<decltype(args.get(instance))> &>(args.get(instance))))), ...);
+                ((key == args.name() && (found = true) && (err = deserializeFromJSON<E>(parser, const_cast<std::remove_cvref_t<decltype(args.get(instance))> &>(args.get(instance))))), ...);
             }, tup);
         return found;
     }
@@ -203,26 +318,177 @@ namespace Details
     template <class> struct is_bounded_char_array : std::false_type {};
     template <size_t N> struct is_bounded_char_array<char[N]> : std::true_type {};
     template <typename T> constexpr bool is_bounded_char_array_v = is_bounded_char_array<T>::value;
+    // Fixed size arrays (either C style or std::array) traits
+    template <typename>             struct FixedArray : std::false_type { };
+    template <typename T, size_t N> struct FixedArray<T[N]> : std::true_type { typedef T value_type; static constexpr size_t count = N; };
+    template <typename T, size_t N> struct FixedArray<std::array<T, N>> : std::true_type { typedef T value_type; static constexpr size_t count = N; };
 #ifdef AllowSerializingDynamicContainer
     template <typename>                     struct IsStdContainer : std::false_type { };
     template <typename T, typename... Ts>   struct IsStdContainer<std::vector<T, Ts...>> : std::true_type { };
     template <typename T, size_t N>         struct IsStdContainer<std::array<T, N>> : std::true_type { };
     template <typename T, typename... Ts>   constexpr bool is_std_container_v = IsStdContainer<T, Ts...>::value;
 #endif
+    // Byte containers serialized as base64 strings
+    template <typename>                     struct IsBase64Bytes : std::false_type { };
+    template <typename C>                   struct IsBase64Bytes<Base64Bytes<C>> : std::true_type { };
+#ifdef JSONBytesAsBase64
+    template <size_t N>                     struct IsBase64Bytes<uint8[N]> : std::true_type { };
+    template <size_t N>                     struct IsBase64Bytes<std::array<uint8, N>> : std::true_type { };
+    template <typename... Ts>               struct IsBase64Bytes<std::vector<uint8, Ts...>> : std::true_type { };
+#endif
+    template <typename T>                   constexpr bool is_base64_bytes_v = IsBase64Bytes<std::remove_cv_t<T>>::value;
 
-    template <typename U>
-    RWString deserializeFromBasicType(Parser & parser, U & t)
+    /** Get the value of an hexadecimal digit or -1 if invalid */
+    inline int hexDigitValue(const char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    /** Parse the 4 hexadecimal digits of a \\u escape sequence. @return the code unit or -1 if invalid */
+    inline int32 parseHexQuad(const char * in)
+    {
+        int32 v = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            int d = hexDigitValue(in[i]);
+            if (d < 0) return -1;
+            v = (v << 4) | d;
+        }
+        return v;
+    }
+
+    /** Encode the given code point to UTF-8. @return the number of bytes used */
+    inline size_t encodeUTF8(const uint32 cp, char (&o)[4])
+    {
+        if (cp < 0x80)    { o[0] = (char)cp; return 1; }
+        if (cp < 0x800)   { o[0] = (char)(0xC0 | (cp >> 6)); o[1] = (char)(0x80 | (cp & 0x3F)); return 2; }
+        if (cp < 0x10000) { o[0] = (char)(0xE0 | (cp >> 12)); o[1] = (char)(0x80 | ((cp >> 6) & 0x3F)); o[2] = (char)(0x80 | (cp & 0x3F)); return 3; }
+        o[0] = (char)(0xF0 | (cp >> 18)); o[1] = (char)(0x80 | ((cp >> 12) & 0x3F)); o[2] = (char)(0x80 | ((cp >> 6) & 0x3F)); o[3] = (char)(0x80 | (cp & 0x3F));
+        return 4;
+    }
+
+    /** Unescape a JSON string (without its quotes).
+        The decoded text is never larger than the input, so the output can be the input buffer itself (in place decoding).
+        Runs of chars without backslash are found with memchr and copied at once.
+        \\u escapes are decoded to UTF-8, including surrogate pairs (a lone surrogate is replaced by U+FFFD).
+        @param in       The escaped text
+        @param len      The escaped text length in bytes
+        @param out      The output buffer (can be equal to in)
+        @param outSize  The output buffer size in bytes. If the output is larger, it's truncated
+        @return The decoded length (that can be larger than outSize if truncated), or (size_t)-1 on invalid escape sequence */
+    inline size_t unescapeJSON(const char * in, size_t len, char * out, const size_t outSize)
+    {
+        size_t o = 0;
+        auto emit = [out, outSize, &o](const char * p, const size_t n)
+        {
+            if (o < outSize && out + o != p) memmove(out + o, p, min(n, outSize - o));
+            o += n;
+        };
+        while (len)
+        {
+            const char * bs = (const char*)memchr(in, '\\', len);
+            if (!bs) { emit(in, len); break; }
+            size_t clean = (size_t)(bs - in);
+            emit(in, clean);
+            in += clean + 1; len -= clean + 1;
+            if (!len) return (size_t)-1;
+
+            char c = *in++; len--;
+            switch (c)
+            {
+            case '"': case '\\': case '/': break;
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case 'u':
+            {
+                if (len < 4) return (size_t)-1;
+                int32 cp = parseHexQuad(in);
+                if (cp < 0) return (size_t)-1;
+                in += 4; len -= 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF)
+                {
+                    int32 low = len >= 6 && in[0] == '\\' && in[1] == 'u' ? parseHexQuad(in + 2) : -1;
+                    if (low >= 0xDC00 && low <= 0xDFFF) { cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00); in += 6; len -= 6; }
+                    else cp = 0xFFFD;
+                }
+                else if (cp >= 0xDC00 && cp <= 0xDFFF) cp = 0xFFFD;
+                char utf8[4];
+                emit(utf8, encodeUTF8((uint32)cp, utf8));
+                continue;
+            }
+            default: return (size_t)-1;
+            }
+            emit(&c, 1);
+        }
+        return o;
+    }
+
+    /** Decode an escaped base64 text (some encoders escape the slash) without allocating.
+        The text is unescaped in a small stack buffer, that's decoded each time it's full.
+        @return The number of bytes decoded or (size_t)-1 if the text is invalid or the output buffer too small */
+    inline size_t decodeEscapedBase64(const char * in, const size_t len, uint8 * out, const size_t outSize)
+    {
+        char buffer[256];
+        size_t used = 0, o = 0;
+        for (size_t i = 0; i < len;)
+        {
+            // Unescape a single char or escape sequence at a time, so a sequence is never split (a \u escape producing
+            // anything outside the base64 alphabet is rejected when decoding)
+            const size_t n = in[i] != '\\' ? 1 : i + 1 < len && in[i + 1] == 'u' ? 6 : 2;
+            const size_t u = unescapeJSON(in + i, min(n, len - i), buffer + used, sizeof(buffer) - used);
+            if (u == (size_t)-1) return (size_t)-1;
+            used += u; i += n;
+            if (used + 4 > sizeof(buffer) && i < len)
+            {   // Only whole quantums are decoded here, and they can't be padded since more text follows
+                const size_t whole = used / 4 * 4;
+                if (Tools::Base64::decode(buffer, whole, out + o, outSize - o) != whole / 4 * 3) return (size_t)-1;
+                o += whole / 4 * 3; used -= whole;
+                memmove(buffer, buffer + whole, used);
+            }
+        }
+        const size_t last = Tools::Base64::decode(buffer, used, out + o, outSize - o);
+        return last == (size_t)-1 ? last : o + last;
+    }
+
+    /** Decode the current number token to the given arithmetic type.
+        Integers are decoded with an integer kernel, so they don't lose precision, and overflow is detected.
+        @return An error message or null on success */
+    template <typename P, typename V>
+    const char * decodeNumber(P & parser, V & v)
+    {
+        if (parser.token.type != P::JSON::Token::Number) return "Expected number";
+        switch (JSONNumber::parse(parser.current(), v))
+        {
+        case JSONNumber::Ok:         return 0;
+        case JSONNumber::OutOfRange: return "Number out of range for the destination type";
+        case JSONNumber::NotInteger: return "Expected an integer number";
+        case JSONNumber::TooLong:    return "Number text too long";
+        default:                     return "Invalid number";
+        }
+    }
+
+    template <typename E, typename P, typename U>
+    E deserializeFromBasicType(P & parser, U & t)
     {
         using T = std::decay_t<U>;
-        if (parser.currentState() != Parser::JSON::HadValue) return "Expected value";
+        if (parser.currentState() != P::JSON::HadValue) return "Expected value";
         if constexpr (std::is_enum_v<T>)
         {
             // We accept either the enum name as string or the enum value here
-            ROString val = parser.getString();
-            if (val[0] >= '0' && val[0] <= '9') // Only positive integer supported here
-                t = static_cast<T>(parser.getInt());
+            if (parser.token.type == P::JSON::Token::Number)
+            {
+                std::underlying_type_t<T> v;
+                if (const char * err = decodeNumber(parser, v)) return err;
+                t = static_cast<T>(v);
+            }
             else
-                t = Refl::from_enum_value(val, T{});
+                t = Refl::from_enum_value(parser.getString(), T{});
         }
         else if constexpr (std::is_same_v<T, bool>)
         {
@@ -230,32 +496,107 @@ namespace Details
         }
         else if constexpr (std::is_arithmetic_v<T>)
         {
-            double v = parser.getDouble();
-            t = static_cast<T>(v);
+            if (const char * err = decodeNumber(parser, t)) return err;
         }
         else if constexpr (std::is_same_v<T, RWString>)
         {
-            t = parser.getString();
+            ROString json = parser.getString();
+            // Most strings don't contain any escape sequence, so only a single scan is required for them
+            if (!memchr(json.getData(), '\\', json.getLength())) t = json;
+            else
+            {
+                RWString tmp(0, json.getLength());
+                size_t len = unescapeJSON(json.getData(), json.getLength(), tmp.map(), json.getLength());
+                if (len == (size_t)-1) return "Invalid escape sequence in string";
+                tmp.limitTo(len).map()[len] = 0;
+                t.swapWith(tmp);
+            }
         }
         else if constexpr (std::is_same_v<T, std::string>)
         {
-            t = std::string(parser.getString().getData(), parser.getString().getLength());
+            ROString json = parser.getString();
+            t.assign(json.getData(), json.getLength());
+            if (memchr(json.getData(), '\\', json.getLength()))
+            {   // Decode in place, since the output is never larger than the input
+                size_t len = unescapeJSON(t.data(), t.length(), t.data(), t.length());
+                if (len == (size_t)-1) return "Invalid escape sequence in string";
+                t.resize(len);
+            }
         }
         else if constexpr (is_bounded_char_array_v<U>)
         {
             ROString json = parser.getString();
             memset(t, 0, sizeof(t));
-            if (json.getLength() < sizeof(t))
-                memcpy(t, json.getData(), json.getLength());
-            else return "Given text is too large for the destination array";
+            size_t len = unescapeJSON(json.getData(), json.getLength(), t, sizeof(t) - 1);
+            if (len == (size_t)-1) return "Invalid escape sequence in string";
+            if (len >= sizeof(t)) return "Given text is too large for the destination array";
         }
-        else if constexpr (std::is_same_v<T, std::string_view> || std::is_convertible_v<T, const char *>)
+        else if constexpr (std::is_same_v<T, ROString> || std::is_same_v<T, std::string_view>)
         {
-            static_assert(Refl::always_false_v<T>, "std::string_view or const char* are not deserializable, since the source will disappear after deserialization");
+            static_assert(P::borrowed, "String views can only be deserialized in borrowed mode (see deserializeBorrowed), since the source will disappear after deserialization");
+            ROString json = parser.getString();
+            if (memchr(json.getData(), '\\', json.getLength()))
+            {   // Escaped text can't be referenced directly, so unescape it in the scratch arena
+                if (!parser.scratch) return "Escaped string requires a scratch arena";
+                char * buffer = parser.scratch->template allocateArray<char>(json.getLength());
+                if (!buffer) return "Scratch arena exhausted";
+                size_t len = unescapeJSON(json.getData(), json.getLength(), buffer, json.getLength());
+                if (len == (size_t)-1) return "Invalid escape sequence in string";
+                json = ROString(buffer, (int)len);
+            }
+            if constexpr (std::is_same_v<T, ROString>) t = json;
+            else t = std::string_view(json.getData(), json.getLength());
         }
+        else if constexpr (std::is_same_v<T, ArenaString>)
+        {
+            if (!parser.scratch) return "Arena strings can only be deserialized with an arena";
+            ROString json = parser.getString();
+            char * buffer = parser.scratch->template allocateArray<char>(json.getLength() + 1);
+            if (!buffer) return "Arena exhausted";
+            size_t len = unescapeJSON(json.getData(), json.getLength(), buffer, json.getLength());
+            if (len == (size_t)-1) return "Invalid escape sequence in string";
+            buffer[len] = 0;
+            t = ROString(buffer, (int)len);
+        }
+        else if constexpr (std::is_convertible_v<T, const char *>)
+        {
+            static_assert(Refl::always_false_v<T>, "const char* are not deserializable, since the source will disappear after deserialization and it's not zero terminated");
+        }
+
+        parser.parseNext();
+        return E();
+    }
 
+    /** Deserialize the elements of an array directly into their destination.
+        Arrays of numbers (or booleans) are converted back to back, without going through the generic per element dispatch.
+        @param capacity     The maximum number of elements the destination can hold
+        @param element      A callable returning a reference to the destination of the given element index */
+    template <typename E, typename V, typename P, typename Element>
+    E deserializeArrayElements(P & parser, const size_t capacity, Element && element)
+    {
+        size_t i = 0;
+        for (; parser.currentState() != P::JSON::LeavingArray; i++)
+        {
+            if (i >= capacity)
+            {
+                if constexpr (std::is_same_v<E, RWString>) return RWString::format("Array size (%d) too small", (int)capacity);
+                else return "Array too small";
+            }
+            if constexpr (std::is_arithmetic_v<V>)
+            {
+                if (parser.currentState() != P::JSON::HadValue) return "Expected value";
+                if constexpr (std::is_same_v<V, bool>) element(i) = parser.getBool();
+                else if (const char * err = decodeNumber(parser, element(i))) return err;
+                parser.parseNext();
+            }
+            else
+            {
+                E ret = deserializeFromJSON<E>(parser, element(i));
+                if (ret) return ret;
+            }
+        }
         parser.parseNext();
-        return "";
+        return E();
     }
 
     template <typename T>
@@ -267,88 +608,100 @@ namespace Details
         else if constexpr (is_bounded_char_array_v<T>) return true;
         else if constexpr (std::is_convertible_v<T, const char *> || std::is_same_v<T, RWString>) return true;
         else if constexpr (std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>) return true;
+        else if constexpr (std::is_same_v<T, ROString> || std::is_same_v<T, ArenaString>) return true;
         else return false;
     }
 
+    /** Decode a base64 string to a byte container. A fixed size container must be completely filled */
+    template <typename E, typename P, typename U>
+    E deserializeBase64(P & parser, U & t)
+    {
+        if (parser.currentState() != P::JSON::HadValue || parser.token.type != P::JSON::Token::String) return "Expected base64 string";
+        const ROString text = parser.getString();
+        // Escaped text is rare (some encoders escape the slash), and it's unescaped on the fly, so nothing is allocated
+        const bool escaped = memchr(text.getData(), '\\', text.getLength()) != 0;
+        auto decode = [&](uint8 * out, const size_t size)
+        {
+            return escaped ? decodeEscapedBase64(text.getData(), text.getLength(), out, size)
+                           : Tools::Base64::decode(text.getData(), text.getLength(), out, size);
+        };
+        size_t len;
+        if constexpr (requires { t.resize(1); })
+        {   // Escapes only shrink the text, so this is still an upper bound for the decoded size
+            t.resize(Tools::Base64::decodedSize(text.getLength()));
+            len = decode((uint8*)std::data(t), std::size(t));
+            if (len != (size_t)-1) t.resize(len);
+        }
+        else
+        {
+            len = decode((uint8*)std::data(t), std::size(t));
+            if (len != (size_t)-1 && len != std::size(t)) return "Base64 data doesn't match the destination size";
+        }
+        if (len == (size_t)-1) return "Invalid base64 string";
+        parser.parseNext();
+        return E();
+    }
+
     /** Deserialize from a JSON string to the expected type.
         @param json   The JSON string to deserialize from
         @param t      The expected type that should map the JSON string
-        @return       An error string on failure or empty string on success */
-    template <typename U>
-    RWString deserializeFromJSON(Parser & parser, U & t, const bool allowPartial)
+        @param E      The error type, either RWString or const char * (static messages, so nothing is allocated)
+        @return       An error string on failure or empty string (or null) on success */
+    template <typename E, typename P, typename U>
+    E deserializeFromJSON(P & parser, U & t, const bool allowPartial)
     {
         using T = std::decay_t<U>;
-        if constexpr (isBasicType<T>())
-            return deserializeFromBasicType(parser, t);
+        if constexpr (is_base64_bytes_v<U>)
+            return deserializeBase64<E>(parser, t);
+        else if constexpr (isBasicType<T>())
+            return deserializeFromBasicType<E>(parser, t);
  #ifdef AllowSerializingDynamicContainer
         else if constexpr (is_std_container_v<T>)
         {
-            if (parser.currentState() != Parser::JSON::EnteringArray) return "Expecting JSON array";
-            parser.parseNext();
-
-            T tmp;
-
-            size_t i = 0;
-            typename T::value_type V;
-            while (true)
+            if (parser.currentState() != P::JSON::EnteringArray) return "Expecting JSON array";
+            if constexpr (requires { t.reserve(1); })
             {
-                if (parser.currentState() == Parser::JSON::LeavingArray) break;
-
-                RWString ret = deserializeFromJSON(parser, V);
-                if (ret) return ret;
-
-                if constexpr (requires { tmp.push_back(V); })
-                    tmp.push_back(V);
-                else
-                {
-                    if (tmp.size() > i)
-                        tmp[i] = V;
-                    else
-                        return RWString::format("Array size (%d) too small", (int)tmp.size());
-                    i++;
+                // Count the elements first so the storage is allocated once
+                if constexpr (Tools::IsArenaAllocator<typename T::allocator_type>::value)
+                {   // Bind the vector to the arena
+                    if (!parser.scratch) return "Arena vectors can only be deserialized with an arena";
+                    // Previous storage from an arena is released with its arena, and it's stale if the arena was reset
+                    // since, so it's dropped without destructing the elements or deallocating it
+                    if (t.get_allocator().arena) new (&t) T(typename T::allocator_type(parser.scratch));
+                    else t = T(typename T::allocator_type(parser.scratch));
                 }
+                else t.clear();
+                t.reserve(JSONScan::countArrayElements(parser.data.getData(), parser.data.getLength(), parser.token.end));
+                parser.parseNext();
+                return deserializeArrayElements<E, typename T::value_type>(parser, (size_t)-1, [&t](size_t) -> decltype(auto) { t.emplace_back(); return t.back(); });
+            }
+            else
+            {
+                for (auto & elem : t) elem = typename T::value_type{};
+                parser.parseNext();
+                return deserializeArrayElements<E, typename T::value_type>(parser, t.size(), [&t](size_t i) -> decltype(auto) { return t[i]; });
             }
-            t.swap(tmp);
-            parser.parseNext();
-            return "";
         }
 #endif
         else if constexpr (std::is_array_v<U>)
         {
-            if (parser.currentState() != Parser::JSON::EnteringArray) return "Expecting JSON array";
-            parser.parseNext();
-
-            std::decay_t<decltype(*t)> V;
-            size_t i = 0, size = sizeof(t) / sizeof(V);
-
-            for (size_t j = 0; j < size; j++) t[j] = decltype(V){}; // Clear array, since we can't be sure we'll find as many value as there were in the array
-
-            while (true)
-            {
-                if (parser.currentState() == Parser::JSON::LeavingArray) break;
-
-                RWString ret = deserializeFromJSON(parser, V);
-                if (ret) return ret;
-
-                if (i < size)
-                    t[i] = V;
-                else
-                    return RWString::format("Array size (%d) too small", (int)size);
-                i++;
-            }
+            if (parser.currentState() != P::JSON::EnteringArray) return "Expecting JSON array";
+            using V = std::remove_cvref_t<decltype(*t)>;
+            const size_t size = sizeof(t) / sizeof(V);
+            for (size_t j = 0; j < size; j++) t[j] = V{}; // Clear array, since we can't be sure we'll find as many value as there were in the array
             parser.parseNext();
-            return "";
+            return deserializeArrayElements<E, V>(parser, size, [&t](size_t i) -> decltype(auto) { return t[i]; });
         }
         else if constexpr (std::is_aggregate_v<T>)
         {
-            if (parser.currentState() != Parser::JSON::EnteringObject) return "Expecting JSON object";
+            if (parser.currentState() != P::JSON::EnteringObject) return "Expecting JSON object";
             // Remove object bracket
             const auto& members = Refl::Members::get_member_functors<T>(0);
             parser.parseNext();
-            RWString err;
+            E err{};
             while (true)
             {
-                if (parser.currentState() == Parser::JSON::LeavingObject) break;
+                if (parser.currentState() == P::JSON::LeavingObject) break;
                 ROString key = parser.nextObjectKey();
                 if (!key) return "Expecting object key";
                 // Find the member with the given name and deserialize it
@@ -356,12 +709,12 @@ namespace Details
                 if (!ret && allowPartial)
                     // Key not found in the given partial object, so we don't have a schema to continue parsing, let's give up.
                     // TODO: add an ignore value function to the parser to continue parsing nonetheless.
-                    return "";
+                    return E();
 
                 if (err) return err;
             }
             parser.parseNext();
-            return "";
+            return E();
         }
         else
         {
@@ -370,77 +723,471 @@ namespace Details
         }
     }
 
+    /** Check if the given type is deserialized from a JSON object (a reflected struct, not a basic type or an array) */
+    template <typename U>
+    consteval bool isNestedObject()
+    {
+        using T = std::remove_cv_t<U>;
+        if constexpr (isBasicType<std::decay_t<T>>() || std::is_array_v<T> || is_base64_bytes_v<T>) return false;
+#ifdef AllowSerializingDynamicContainer
+        else if constexpr (is_std_container_v<T>) return false;
+#endif
+        else return std::is_aggregate_v<T>;
+    }
+
+    /** Patch the given object with the members found in the JSON text.
+        Nested objects are patched recursively, any other member found is replaced completely.
+        @return An error string on failure or empty string on success */
+    template <typename P, typename U>
+    RWString applyDeltaFromJSON(P & parser, U & t)
+    {
+        if constexpr (isNestedObject<U>())
+        {
+            if (parser.currentState() != P::JSON::EnteringObject) return "Expecting JSON object";
+            const auto & members = Refl::Members::get_member_functors<U>(0);
+            parser.parseNext();
+            while (parser.currentState() != P::JSON::LeavingObject)
+            {
+                ROString key = parser.nextObjectKey();
+                if (!key) return "Expecting object key";
+                bool found = false;
+                RWString err;
+                std::apply([&](auto const & ... args)
+                    {
+                        ((!found && key == args.name() && (found = true) && (err = applyDeltaFromJSON(parser, const_cast<std::remove_cvref_t<decltype(args.get(t))> &>(args.get(t))))), ...);
+                    }, members);
+                if (!found) return "Unknown member in delta";
+                if (err) return err;
+            }
+            parser.parseNext();
+            return "";
+        }
+        else return deserializeFromJSON(parser, t);
+    }
+
+    /** Check if the given type can be deserialized without any allocation: numbers, enums, bools, char[N], fixed size
+        arrays and std::array of these, and aggregates made of these (recursively) */
+    template <typename U>
+    consteval bool isNoAllocType()
+    {
+        using T = std::remove_cv_t<U>;
+        if constexpr (std::is_enum_v<T> || std::is_arithmetic_v<T> || is_bounded_char_array_v<T>) return true;
+        else if constexpr (FixedArray<T>::value) return isNoAllocType<typename FixedArray<T>::value_type>();
+        // Base64 text is decoded directly to a fixed size container, but a resizable one allocates
+        else if constexpr (is_base64_bytes_v<T>) return !requires (T & t) { t.resize(1); };
+        else if constexpr (isBasicType<std::decay_t<T>>()) return false;
+#ifdef AllowSerializingDynamicContainer
+        else if constexpr (is_std_container_v<T>) return false;
+#endif
+        else if constexpr (std::is_aggregate_v<T>)
+        {
+            using Members = std::remove_cvref_t<decltype(Refl::Members::get_member_functors<T>(0))>;
+            return []<size_t ... Ix>(std::index_sequence<Ix...>)
+            {
+                return (isNoAllocType<typename std::tuple_element_t<Ix, Members>::template type<>>() && ... && true);
+            }(std::make_index_sequence<std::tuple_size_v<Members>>{});
+        }
+        else return false;
+    }
+
+    /** Write the JSON escape sequence for the given char (that must require escaping) in the given buffer.
+        @return the escape sequence length */
+    inline size_t escapeJSONChar(const char c, char (&o)[6])
+    {
+        static const char hexDigits[] = "0123456789abcdef";
+        o[0] = '\\';
+        switch (c)
+        {
+        case '"':  o[1] = '"';  return 2;
+        case '\\': o[1] = '\\'; return 2;
+        case '\b': o[1] = 'b';  return 2;
+        case '\f': o[1] = 'f';  return 2;
+        case '\n': o[1] = 'n';  return 2;
+        case '\r': o[1] = 'r';  return 2;
+        case '\t': o[1] = 't';  return 2;
+        default:
+            o[1] = 'u'; o[2] = '0'; o[3] = '0'; o[4] = hexDigits[(uint8)c >> 4]; o[5] = hexDigits[c & 0xF];
+            return 6;
+        }
+    }
+
+    /** Find the first char that needs escaping in a JSON string (this is vectorized) */
+    inline size_t findJSONEscape(const char * str, const size_t len) { return Tools::findFirstOf<0x20, '"', '\\'>(str, len); }
+
+    /** Write the given string with JSON escaping to the sink.
+        Runs of chars that don't need escaping are found with a vectorized search and written at once */
+    template <Tools::Sink S>
+    inline void serializeEscaped(S & out, const char * str, size_t len)
+    {
+        while (len)
+        {
+            size_t clean = findJSONEscape(str, len);
+            out.write(str, clean);
+            if (clean == len) return;
+            char esc[6];
+            out.write(esc, escapeJSONChar(str[clean], esc));
+            str += clean + 1; len -= clean + 1;
+        }
+    }
+
 #ifdef AllowSerializing
-    // Forward declare the class
+    // Forward declare the function
+    template <Tools::Sink S, typename U>
+    void serializeToJSON(S & out, const U & t);
+
+    /** Write a quoted and escaped string to the sink */
+    template <Tools::Sink S>
+    inline void serializeString(S & out, const char * str, const size_t len) { out.put('"'); serializeEscaped(out, str, len); out.put('"'); }
+
+    /** The precomputed key fragments for an aggregate type.
+        Each member gets a fragment made of the opening brace (first member) or the comma separator (next members),
+        followed by the quoted member name and the colon, like this: {"a": ,"b": ,"c":
+        All fragments are stored contiguously in a constexpr table, so writing the structural text of an
+        aggregate is reduced to copying known length chunks. Member names are C++ identifiers, they never need escaping. */
     template <typename T>
-    RWString serializeToJSONKeyValue(const ROString & key, const T & t);
-
-    // Compile time visitor pattern for a aggregate converted to a tuple of reflected members
-    template <typename T, typename ... Members>
-    void serializeToJSONMembers(RWString & str, const T & instance, std::tuple<Members...> const & tup)
+    struct JSONKeyFragments
     {
-        std::apply(
-            [&str, &instance](Members const &... args)
+        using Members = std::remove_cvref_t<decltype(Refl::Members::get_member_functors<T>(0))>;
+        static constexpr size_t count = std::tuple_size_v<Members>;
+
+        template <size_t ... Ix>
+        static consteval size_t computeSize(std::index_sequence<Ix...>) { return ((std::tuple_element_t<Ix, Members>::name().getLength() + 4) + ... + 0); }
+        static constexpr size_t size = computeSize(std::make_index_sequence<count>{});
+
+        struct Table
+        {
+            char   text[size + 1];
+            size_t offsets[count + 1];
+        };
+
+        template <size_t ... Ix>
+        static consteval Table buildTable(std::index_sequence<Ix...>)
+        {
+            Table table{};
+            size_t pos = 0;
+            auto append = [&table, &pos](const size_t index, const ROString & name)
             {
-                ((str += serializeToJSONKeyValue(args.name(), args.get(instance)) + ","), ...);
-            }, tup);
+                table.offsets[index] = pos;
+                table.text[pos++] = index ? ',' : '{';
+                table.text[pos++] = '"';
+                for (size_t i = 0; i < name.getLength(); i++) table.text[pos++] = name.getData()[i];
+                table.text[pos++] = '"';
+                table.text[pos++] = ':';
+            };
+            (append(Ix, std::tuple_element_t<Ix, Members>::name()), ...);
+            table.offsets[count] = pos;
+            return table;
+        }
+        static constexpr Table table = buildTable(std::make_index_sequence<count>{});
+
+        /** Get the fragment for the given member index */
+        template <size_t Ix>
+        static constexpr ROString fragment() { return ROString(table.text + table.offsets[Ix], (int)(table.offsets[Ix + 1] - table.offsets[Ix])); }
+    };
+
+    // Compile time visitor pattern for a aggregate's reflected members
+    template <Tools::Sink S, typename T, size_t ... Ix>
+    void serializeToJSONMembers(S & out, const T & instance, std::index_sequence<Ix...>)
+    {
+        using Keys = JSONKeyFragments<T>;
+        ((out.write(Keys::table.text + Keys::table.offsets[Ix], Keys::table.offsets[Ix + 1] - Keys::table.offsets[Ix]),
+          serializeToJSON(out, std::tuple_element_t<Ix, typename Keys::Members>::get(instance))), ...);
+    }
+
+    /** Format a number in the given buffer, with JSONFloatPrecision significant digits (or the shortest round trip text).
+        The buffer must be at least 32 bytes. @return The text length */
+    template <typename T>
+    inline size_t formatNumber(char * buf, const T v)
+    {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        // Same output as printf, but without parsing a format string or checking the locale
+        std::to_chars_result r;
+        if constexpr (JSONFloatPrecision == 0) r = std::to_chars(buf, buf + 32, v);
+        else r = std::to_chars(buf, buf + 32, (double)v, std::chars_format::general, JSONFloatPrecision);
+        return r.ec == std::errc() ? (size_t)(r.ptr - buf) : 0;
+#else
+        int len;
+        if constexpr (JSONFloatPrecision != 0) len = snprintf(buf, 32, "%.*g", JSONFloatPrecision, (double)v);
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) len = snprintf(buf, 32, "%lld", (long long)v);
+        else if constexpr (std::is_integral_v<T>) len = snprintf(buf, 32, "%llu", (unsigned long long)v);
+        // Not the shortest text, but it reads back to the same value
+        else len = snprintf(buf, 32, "%.*g", std::numeric_limits<T>::max_digits10, (double)v);
+        return (size_t)min(max(len, 0), 31);
+#endif
+    }
+
+    /** Write an array of numbers. The elements are formatted back to back in a stack buffer that's flushed to the sink
+        when full, so the sink is only called once for many elements */
+    template <Tools::Sink S, typename V>
+    void serializeNumberArray(S & out, const V * data, const size_t count)
+    {
+        char buffer[512];
+        size_t used = 0;
+        buffer[used++] = '[';
+        for (size_t i = 0; i < count; i++)
+        {
+            if (used > sizeof(buffer) - 34) { out.write(buffer, used); used = 0; }
+            if (i) buffer[used++] = ',';
+            used += formatNumber(buffer + used, data[i]);
+        }
+        buffer[used++] = ']';
+        out.write(buffer, used);
     }
 
+    /** Check if the given type is a contiguous array of numbers (but not booleans) */
     template <typename U>
-    RWString serializeBasicType(const U & t)
+    consteval bool isNumberArray()
+    {
+        using T = std::remove_cv_t<U>;
+        if constexpr (is_std_container_v<T> || std::is_array_v<T>)
+        {
+            // std::vector<bool> doesn't have contiguous storage, so don't ask for it
+            using V = std::iter_value_t<decltype(std::begin(std::declval<T &>()))>;
+            return std::is_arithmetic_v<V> && !std::is_same_v<V, bool>;
+        }
+        else return false;
+    }
+
+    template <Tools::Sink S, typename U>
+    void serializeBasicType(S & out, const U & t)
     {
         using T = std::decay_t<U>;
         if constexpr (std::is_enum_v<T>)
-            return RWString::format("\"%s\"",Refl::enum_value_name(t));
+        {
+            const char * name = Refl::enum_value_name(t);
+            serializeString(out, name, strlen(name));
+        }
         else if constexpr (std::is_same_v<T, bool>)
-            return RWString(t ? "true" : "false");
+        {
+            if (t) out.write("true", 4); else out.write("false", 5);
+        }
         else if constexpr (std::is_arithmetic_v<T>)
-            return RWString::format("%g", (double)t);
-        else if constexpr (std::is_convertible_v<T, const char *> || std::is_same_v<T, RWString>)
-            return RWString::format("\"%s\"", (const char*)t);
+        {
+            char buf[32];
+            out.write(buf, formatNumber(buf, t));
+        }
+        else if constexpr (is_bounded_char_array_v<U>)
+            serializeString(out, t, strnlen(t, sizeof(t)));
+        else if constexpr (std::is_same_v<T, RWString>)
+            serializeString(out, t.getData(), t.getLength());
+        else if constexpr (std::is_convertible_v<T, const char *>)
+            serializeString(out, (const char*)t, t ? strlen((const char*)t) : 0);
         else if constexpr (std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>)
-            return RWString::format("\"%.*s\"", t.length(), t.data());
-        else if constexpr (std::is_same_v<T, ROString>)
-            return RWString::format("\"%.*s\"", t.getLength(), t.getData());
-        return "";
+            serializeString(out, t.data(), t.length());
+        else if constexpr (std::is_same_v<T, ROString> || std::is_same_v<T, ArenaString>)
+            serializeString(out, t.getData(), t.getLength());
     }
 
-    /** Serialize an aggregate object (or JSON basic type) to a JSON string.
-        This doesn't handle array yet */
-    template <typename U>
-    RWString serializeToJSONKeyValue(const ROString & key, const U & t)
+    /** Serialize an aggregate object, an array or a JSON basic type to the given sink.
+        Nothing is allocated here, the output is written to the sink as it's produced */
+    template <Tools::Sink S, typename U>
+    void serializeToJSON(S & out, const U & t)
     {
         using T = std::decay_t<U>;
 
-        RWString res = key ? RWString::format("\"%.*s\":", key.getLength(), key.getData()) : "";
-        if constexpr (isBasicType<T>())
-            return res + serializeBasicType(t);
+        if constexpr (is_base64_bytes_v<U>)
+        {
+            out.put('"');
+            Tools::Base64::encode(out, (const uint8*)std::data(t), std::size(t));
+            out.put('"');
+        }
+        else if constexpr (isBasicType<T>())
+            serializeBasicType(out, t);
+        else if constexpr (isNumberArray<U>())
+            serializeNumberArray(out, std::data(t), std::size(t));
         else if constexpr (is_std_container_v<T> || std::is_array_v<U>)
         {
             // Need to create an JSON array here
-            res += '[';
+            out.put('[');
+            bool first = true;
             for (auto const & elem : t)
-                res += serializeToJSONKeyValue("", elem) + ",";
-            if (res[res.getLength() - 1] == ',')
-                res[res.getLength() - 1] = ']';
-            else res += ']';
-            return res;
+            {
+                if (!first) out.put(',');
+                first = false;
+                serializeToJSON(out, elem);
+            }
+            out.put(']');
         }
         else if constexpr (std::is_aggregate_v<T>)
         {
-            const auto& members = Refl::Members::get_member_functors<T>(0);
-            res += '{'; serializeToJSONMembers(res, t, members);
-            if (res[res.getLength() - 1] == ',')
-                res[res.getLength() - 1] = '}';
-            else res += '}';
-            return res;
+            using Keys = JSONKeyFragments<T>;
+            if constexpr (Keys::count == 0) out.put('{');
+            else serializeToJSONMembers(out, t, std::make_index_sequence<Keys::count>{});
+            out.put('}');
         }
         else
         {
             static_assert(Refl::always_false_v<T>, "Can't serialize this type to JSON");
-            return "";
         }
-    };
+    }
+
+    /** Compute the longest enumeration value name at compile time */
+    template <typename E>
+    consteval size_t maxEnumNameLength()
+    {
+        constexpr int minVal = Refl::find_min_value<E, 0>();
+        constexpr size_t maxVal = Refl::find_max_value<E, 0>();
+        constexpr auto names = Refl::enum_value_names<E, (size_t)-minVal, maxVal>();
+        size_t len = 0;
+        for (auto name : names) { size_t l = name ? CompileTime::strlen(name) : 0; if (l > len) len = l; }
+        return len;
+    }
+
+    /** Check if the serialized size of the given type is bounded (no dynamic container or string) */
+    template <typename U>
+    consteval bool hasBoundedJSONSize()
+    {
+        using T = std::remove_cv_t<U>;
+        // Only fixed size byte containers are trivially copyable
+        if constexpr (is_base64_bytes_v<T>) return std::is_trivially_copyable_v<T>;
+        else if constexpr (std::is_enum_v<T> || std::is_arithmetic_v<T> || is_bounded_char_array_v<T>) return true;
+        else if constexpr (FixedArray<T>::value) return hasBoundedJSONSize<typename FixedArray<T>::value_type>();
+        else if constexpr (isBasicType<std::decay_t<T>>() || is_std_container_v<T>) return false;
+        else if constexpr (std::is_aggregate_v<T>)
+        {
+            using Members = typename JSONKeyFragments<T>::Members;
+            return []<size_t ... Ix>(std::index_sequence<Ix...>)
+            {
+                return (hasBoundedJSONSize<typename std::tuple_element_t<Ix, Members>::template type<>>() && ... && true);
+            }(std::make_index_sequence<std::tuple_size_v<Members>>{});
+        }
+        else return false;
+    }
+
+    /** Compute the maximum serialized size of the given type (only valid if hasBoundedJSONSize is true) */
+    template <typename U>
+    consteval size_t maxJSONSize()
+    {
+        using T = std::remove_cv_t<U>;
+        if constexpr (is_base64_bytes_v<T>) return 2 + Tools::Base64::encodedSize(sizeof(T));
+        else if constexpr (std::is_enum_v<T>) return 2 + maxEnumNameLength<T>();
+        else if constexpr (std::is_same_v<T, bool>) return 5;
+        // Small integers are printed completely, else the longest output is like -1.79769e+308 (sign, digits, dot and exponent)
+        else if constexpr (std::is_arithmetic_v<T>)
+        {
+            if constexpr (std::is_integral_v<T>) { if (JSONFloatPrecision == 0 || std::numeric_limits<T>::digits10 < JSONFloatPrecision) return std::numeric_limits<T>::digits10 + 2; }
+            if constexpr (JSONFloatPrecision == 0) return std::numeric_limits<T>::max_digits10 + 7;
+            return JSONFloatPrecision + 7;
+        }
+        // Worst case is when all chars must be escaped as \u00XX
+        else if constexpr (is_bounded_char_array_v<T>) return 2 + 6 * std::extent_v<T>;
+        else if constexpr (FixedArray<T>::value)
+        {
+            constexpr size_t N = FixedArray<T>::count;
+            return 2 + N * maxJSONSize<typename FixedArray<T>::value_type>() + (N ? N - 1 : 0);
+        }
+        else
+        {
+            using Keys = JSONKeyFragments<T>;
+            return []<size_t ... Ix>(std::index_sequence<Ix...>)
+            {
+                return (Keys::count ? Keys::size + 1 : 2) + (maxJSONSize<typename std::tuple_element_t<Ix, typename Keys::Members>::template type<>>() + ... + 0);
+            }(std::make_index_sequence<Keys::count>{});
+        }
+    }
+
+    /** Write the key of the given member, preceded by the given separator */
+    template <typename T, size_t Ix, Tools::Sink S>
+    inline void serializeMemberKey(S & out, const char separator)
+    {
+        constexpr ROString key = JSONKeyFragments<T>::template fragment<Ix>();
+        out.put(separator);
+        out.write(key.getData() + 1, key.getLength() - 1);
+    }
+
+    /** Check if the given values would be serialized the same way (compared member by member for aggregates) */
+    template <typename U>
+    bool sameValue(const U & a, const U & b)
+    {
+        using T = std::decay_t<U>;
+        if constexpr (is_base64_bytes_v<U>) return std::size(a) == std::size(b) && !memcmp(std::data(a), std::data(b), std::size(a));
+        else if constexpr (is_bounded_char_array_v<U>) return !strncmp(a, b, sizeof(a));
+        else if constexpr (std::is_same_v<T, RWString> || std::is_same_v<T, ROString> || std::is_same_v<T, ArenaString>)
+            return a.getLength() == b.getLength() && !memcmp(a.getData(), b.getData(), a.getLength());
+        else if constexpr (std::is_convertible_v<T, const char *>) return a == b || (a && b && !strcmp(a, b));
+        else if constexpr (isBasicType<T>()) return a == b;
+        else if constexpr (is_std_container_v<T> || std::is_array_v<U>)
+        {
+            if (std::size(a) != std::size(b)) return false;
+            auto i = std::begin(b);
+            for (auto const & elem : a) if (!sameValue(elem, *i++)) return false;
+            return true;
+        }
+        else
+        {
+            const auto & members = Refl::Members::get_member_functors<T>(0);
+            return std::apply([&a, &b](auto const & ... args) { return (sameValue(args.get(a), args.get(b)) && ... && true); }, members);
+        }
+    }
+
+    // Forward declare the function
+    template <Tools::Sink S, typename T>
+    void serializeDeltaToJSON(S & out, const T & prev, const T & cur);
+
+    /** Write the members that differ between the given objects */
+    template <Tools::Sink S, typename T, size_t ... Ix>
+    void serializeDeltaMembers(S & out, const T & prev, const T & cur, std::index_sequence<Ix...>)
+    {
+        using Keys = JSONKeyFragments<T>;
+        bool first = true;
+        auto member = [&]<size_t I>(std::integral_constant<size_t, I>)
+        {
+            using M = std::tuple_element_t<I, typename Keys::Members>;
+            if (sameValue(M::get(prev), M::get(cur))) return;
+            serializeMemberKey<T, I>(out, first ? '{' : ',');
+            first = false;
+            if constexpr (isNestedObject<typename M::template type<>>()) serializeDeltaToJSON(out, M::get(prev), M::get(cur));
+            else serializeToJSON(out, M::get(cur));
+        };
+        (member(std::integral_constant<size_t, Ix>{}), ...);
+        if (first) out.put('{');
+        out.put('}');
+    }
+
+    /** Serialize the members of the current object that changed since the previous object.
+        Nested objects are compared recursively, any other member (including arrays) is written completely if it changed */
+    template <Tools::Sink S, typename T>
+    void serializeDeltaToJSON(S & out, const T & prev, const T & cur)
+    {
+        serializeDeltaMembers(out, prev, cur, std::make_index_sequence<JSONKeyFragments<T>::count>{});
+    }
+
+    /** Find the index of the member with the given name at compile time (the member count if not found) */
+    template <typename T, CompileTime::str Name>
+    consteval size_t memberIndex()
+    {
+        using Members = typename JSONKeyFragments<T>::Members;
+        constexpr size_t len = CompileTime::strlen(Name.data);
+        return []<size_t ... Ix>(std::index_sequence<Ix...>)
+        {
+            size_t index = sizeof...(Ix);
+            ((std::tuple_element_t<Ix, Members>::name().getLength() == len
+              && !CompileTime::strncmp(std::tuple_element_t<Ix, Members>::name().getData(), Name.data, (int)len) ? (index = Ix) : 0), ...);
+            return index;
+        }(std::make_index_sequence<std::tuple_size_v<Members>>{});
+    }
+
+    /** Write the given members only, in the given order */
+    template <Tools::Sink S, typename T, size_t ... Ix>
+    void serializeSelectedMembers(S & out, const T & t, std::index_sequence<Ix...>)
+    {
+        using Members = typename JSONKeyFragments<T>::Members;
+        size_t n = 0;
+        ((serializeMemberKey<T, Ix>(out, n++ ? ',' : '{'), serializeToJSON(out, std::tuple_element_t<Ix, Members>::get(t))), ...);
+        if (!n) out.put('{');
+        out.put('}');
+    }
+
+    /** Write the members whose bit is set in the given mask */
+    template <Tools::Sink S, typename T, size_t ... Ix>
+    void serializeMaskedMembers(S & out, const T & t, const uint64 mask, std::index_sequence<Ix...>)
+    {
+        using Members = typename JSONKeyFragments<T>::Members;
+        bool first = true;
+        ((mask & ((uint64)1 << Ix) ? (serializeMemberKey<T, Ix>(out, first ? '{' : ','), first = false, serializeToJSON(out, std::tuple_element_t<Ix, Members>::get(t))) : void()), ...);
+        if (first) out.put('{');
+        out.put('}');
+    }
 
 #endif
 
@@ -459,92 +1206,502 @@ namespace Details
                         This allows to deserialize polymorphic object by deserializing first a common type to figure out
                         what to deserialize next. Beware however that since the schema can't be deduced from the object, if the
                         JSON text doesn't contain the required keys first, you won't get any useful output from this.
+    @param P            The parser to use. The default Parser is limited to 32KB documents, use WideParser for larger one:
+                        @code deserialize<Config, WideParser>(config, json); @endcode
  */
-template <class T>
+template <class T, class P = Parser>
 bool deserialize(T & obj, const ROString & json, const bool allowPartial = false)
 {
-    Parser parser(json);
-    if (parser.currentState() != Parser::JSON::EnteringObject) return false;
+    P parser(json);
+    if (parser.currentState() != P::JSON::EnteringObject) return false;
     RWString err = Details::deserializeFromJSON(parser, obj, allowPartial);
     if (err) return parser.Error(0, err);
     return true;
 }
 
+/** Deserialize in borrowed mode.
+    In this mode, ROString and std::string_view members are allowed, and they point directly inside the source buffer,
+    so no allocation is done for them. Escaped strings can't be referenced directly, so they are unescaped in the
+    given scratch arena.
+    @warning The source buffer and the scratch arena must outlive the deserialized object.
+    @param obj          The object to deserialize into
+    @param json         The JSON read only text
+    @param scratch      The arena used to store the unescaped strings
+    @sa deserialize */
+template <class T, class P = Parser>
+bool deserializeBorrowed(T & obj, const ROString & json, Tools::BumpArena & scratch)
+{
+    typename P::BorrowingParser parser(json);
+    parser.scratch = &scratch;
+    if (parser.currentState() != P::JSON::EnteringObject) return false;
+    RWString err = Details::deserializeFromJSON(parser, obj);
+    if (err) return parser.Error(0, err);
+    return true;
+}
+
+/** Deserialize in borrowed mode without scratch arena.
+    This fails if a string that's deserialized as a view contains escape sequences.
+    @sa deserializeBorrowed */
+template <class T, class P = Parser>
+bool deserializeBorrowed(T & obj, const ROString & json)
+{
+    typename P::BorrowingParser parser(json);
+    if (parser.currentState() != P::JSON::EnteringObject) return false;
+    RWString err = Details::deserializeFromJSON(parser, obj);
+    if (err) return parser.Error(0, err);
+    return true;
+}
+
+/** Deserialize with all the storage allocated in the given arena.
+    ArenaString and ArenaVector members get their text and storage from the arena (nested ones too), and errors are
+    static strings, so deserializing doesn't call malloc and destructing the object doesn't call free: the whole object
+    graph is released at once by resetting the arena. Other members (like RWString or std::vector) are still allocated
+    on the heap, and so are the arena's own blocks when it grows (or when it's exhausted and can't grow).
+    For example:
+    @code
+        struct Item { ArenaString name; ArenaVector<int> values; };
+        struct Request { int id; ArenaVector<Item> items; };
+
+        char buffer[4096];
+        Tools::BumpArena arena(buffer, true);
+        Request req;
+        deserialize(req, json, arena);
+    @endcode
+    Lifetime rule: resetting (or destructing) the arena makes the object's arena storage stale. After that, the object
+    can only be used as the destination of another deserialize with an arena, which drops the stale storage without
+    reading it. Any other use, including destructing the object, reads freed memory. So reuse an object like this:
+    @code
+        Tools::BumpArena arena(buffer, true);
+        Request req; // Declared after the arena, so it's destructed first
+        for (const ROString & json : requests)
+        {
+            arena.reset();
+            deserialize(req, json, arena);
+            handle(req);
+        }
+    @endcode
+    @warning The arena must outlive the deserialized object, and must not be reset while it's in use.
+    @sa deserialize */
+template <class T, class P = Parser>
+bool deserialize(T & obj, const ROString & json, Tools::BumpArena & arena)
+{
+    P parser(json);
+    parser.scratch = &arena;
+    if (parser.currentState() != P::JSON::EnteringObject) return false;
+    if (const char * err = Details::deserializeFromJSON<const char *>(parser, obj)) return parser.Error(0, err);
+    return true;
+}
+
+/** Deserialize without any heap allocation, for real time tasks.
+    Only types whose deserialization can't allocate are accepted, and this is checked at compile time: numbers, enums,
+    bools, char[N], fixed size arrays and std::array (also as base64), and aggregates made of these. Strings and vectors
+    are rejected.
+    The parser doesn't allocate, and errors are static strings reported through the parser's Error method.
+    @param obj          The object to deserialize into
+    @param json         The JSON read only text
+    @return true on success, the error is logged on failure */
+template <class T, class P = Parser>
+bool deserializeNoAlloc(T & obj, const ROString & json)
+{
+    static_assert(Details::isNoAllocType<T>(), "This type contains members whose deserialization allocates (like RWString, std::string or std::vector)");
+    P parser(json);
+    if (parser.currentState() != P::JSON::EnteringObject) return false;
+    if (const char * err = Details::deserializeFromJSON<const char *>(parser, obj)) return parser.Error(0, err);
+    return true;
+}
+
 /** The simple deserializer function that's dealing with arrays.
     @warning A polymorphic array isn't supported, all array element must be the same type
     @sa deserialize */
-template <class T, size_t N>
+template <class T, size_t N, class P = Parser>
 bool deserialize(T (&obj)[N], const ROString & json)
 {
-    Parser parser(json);
-    if (parser.currentState() != Parser::JSON::EnteringArray) return false;
+    P parser(json);
+    if (parser.currentState() != P::JSON::EnteringArray) return false;
     RWString err = Details::deserializeFromJSON(parser, obj);
     if (err) return parser.Error(0, err);
     return true;
 }
 
-#ifdef AllowSerializing
-/** Serialize the given object to a JSON valid string. */
-template <class T>
-RWString serialize(T & obj)
+namespace Details
+{
+    /** Get the discriminator value for the given variant alternative.
+        This is the alternative's static discriminator member if it has one (a string or an enum value), or its type name */
+    template <typename T>
+    consteval ROString variantTag()
+    {
+        if constexpr (requires { T::discriminator; })
+        {
+            if constexpr (std::is_enum_v<std::remove_cvref_t<decltype(T::discriminator)>>) return ROString(Refl::enum_value_name(T::discriminator));
+            else return ROString(T::discriminator);
+        }
+        else
+        {
+            ROString name = Refl::Name::type<T>();
+            size_t i = name.getLength();
+            while (i && name.getData()[i - 1] != ':') i--;
+            return ROString(name.getData() + i, (int)(name.getLength() - i));
+        }
+    }
+
+    /** Check if the given discriminator value selects the given alternative */
+    template <typename T>
+    bool variantMatches(const ROString & tag, const unsigned hash, const bool quoted)
+    {
+        if constexpr (requires { T::discriminator; })
+            if constexpr (std::is_enum_v<std::remove_cvref_t<decltype(T::discriminator)>>)
+                if (!quoted)
+                {   // Enums can also be given by value
+                    int64 v;
+                    return JSONNumber::parseInteger(tag, v) == JSONNumber::Ok && v == (int64)T::discriminator;
+                }
+        static constexpr ROString name = variantTag<T>();
+        static constexpr unsigned expected = CompileTime::constHash(name.getData(), name.getLength());
+        return quoted && hash == expected && tag == name;
+    }
+
+    /** Select the alternative matching the discriminator value and deserialize it */
+    template <typename P, typename ... Alts>
+    bool deserializeVariant(std::variant<Alts...> & obj, const ROString & json, const ROString & tag, const bool quoted)
+    {
+        const unsigned hash = CompileTime::constHash(tag.getData(), tag.getLength());
+        bool found = false, ok = false;
+        [&]<size_t ... Ix>(std::index_sequence<Ix...>)
+        {
+            ((!found && variantMatches<Alts>(tag, hash, quoted) && (found = true) && (ok = deserialize<Alts, P>(obj.template emplace<Ix>(), json))), ...);
+        }(std::index_sequence_for<Alts...>{});
+        if (!found) elogm(Log::Error | Log::Format, "Parse error: Unknown discriminator value: %.*s\n", (int)tag.getLength(), tag.getData());
+        return ok;
+    }
+}
+
+/** Deserialize a polymorphic object in a single pass.
+    The discriminator key is found with a structural scan of the object (so it doesn't need to come first), then its value
+    selects the variant alternative that's deserialized. Each alternative declares its discriminator value with a static
+    member (or it's selected by its type name):
+    @code
+        struct Circle { static constexpr const char * discriminator = "circle"; RWString type; double radius; };
+        struct Rect   { static constexpr Shape discriminator = Shape::Rect; Shape type; double w, h; };
+        std::variant<Circle, Rect> shape;
+        deserializeVariant(shape, json, "type");
+    @endcode
+    Since the complete object is deserialized into the alternative, the discriminator key must be one of its members.
+    @param obj      The variant to deserialize into
+    @param json     The JSON text, containing an object
+    @param key      The discriminator key
+    @return true on success */
+template <class V, class P = Parser>
+bool deserializeVariant(V & obj, const ROString & json, const ROString & key = "type")
 {
-    return Details::serializeToJSONKeyValue("", obj);
+    const char * text = json.getData();
+    const size_t len = json.getLength();
+    size_t pos = JSONScan::skipWhitespace(text, len, 0);
+    if (pos < len && text[pos] == '{') pos = JSONScan::findObjectKey(text, len, pos + 1, key);
+    else pos = len;
+    if (pos == len)
+    {
+        elogm(Log::Error | Log::Format, "Parse error: Discriminator key not found: %.*s\n", (int)key.getLength(), key.getData());
+        return false;
+    }
+    const size_t end = JSONScan::skipValue(text, len, pos);
+    const bool quoted = text[pos] == '"';
+    // A quoted tag running to the end of the text is unterminated, or at least not followed by the object's closing brace
+    if (quoted && (end >= len || end - pos < 2))
+    {
+        elogm(Log::Error | Log::Format, "Parse error: Unterminated discriminator value for key: %.*s\n", (int)key.getLength(), key.getData());
+        return false;
+    }
+    const ROString tag = quoted ? ROString(text + pos + 1, (int)(end - pos - 2)) : ROString(text + pos, (int)(end - pos));
+    return Details::deserializeVariant<P>(obj, json, tag, quoted);
 }
-#endif
 
-/** A JSON escaping dynamic function wrapper. This is used to escape strings so they can respect the JSON format */
-size_t computeJSONStringRequiredSize(const ROString & input)
-{
-    // First pass, count the number of required output char
-    size_t count = 0; const char * p = input.getData();
-    for (size_t i = 0; i < input.getLength(); i++) {
-        switch (p[i]) {
-        case '"': count += 2; break;
-        case '\\': count += 2; break;
-        case '\b': count += 2; break;
-        case '\f': count += 2; break;
-        case '\n': count += 2; break;
-        case '\r': count += 2; break;
-        case '\t': count += 2; break;
-        default:
-            if ((uint8)p[i] <= '\x1f') {
-                count += 6;
-            } else {
-                count++;
-            }
+/** Deserialize newline delimited JSON (also known as NDJSON or JSON Lines), where each line is a JSON object.
+    Record boundaries are found with memchr (a JSON string can't contain a raw newline) and a single parser is reused
+    for all records, so each record is only limited by the parser's maximum size, not the complete batch.
+    Empty lines are skipped. A record that fails to deserialize is reported and the batch continues with the next line.
+
+    Typical usage:
+    @code
+        std::vector<Sample> samples;
+        deserializeLines<Sample>(batch, std::back_inserter(samples), [](size_t line, ROString err) { ... });
+    @endcode
+    @param json     The NDJSON text
+    @param out      The output iterator receiving each deserialized record
+    @param onError  Called with the (zero based) line number and the error message of each failed record
+    @return The number of records written to the output iterator */
+template <class T, class P = Parser, class OutputIt>
+size_t deserializeLines(const ROString & json, OutputIt out, Tools::function_ref<void(size_t, ROString)> onError)
+{
+    const char * text = json.getData();
+    const size_t len = json.getLength();
+    size_t count = 0, line = 0;
+    P parser(ROString(""));
+    for (size_t pos = 0; pos < len; line++)
+    {
+        const char * eol = (const char*)memchr(text + pos, '\n', len - pos);
+        const size_t end = eol ? (size_t)(eol - text) : len;
+        const ROString record(text + pos, (int)(end - pos));
+        pos = end + 1;
+        if (JSONScan::skipWhitespace(record.getData(), record.getLength(), 0) == record.getLength()) continue;
+
+        parser.reset(record);
+        T obj{};
+        RWString err;
+        if (parser.currentState() != P::JSON::EnteringObject) err = "Expecting JSON object";
+        else err = Details::deserializeFromJSON(parser, obj);
+        if (!err && JSONScan::skipWhitespace(record.getData(), record.getLength(), (size_t)parser.parser.pos) != record.getLength())
+            err = "Unexpected data after the record";
+        if (err)
+        {
+            parser.Error(0, err);
+            onError(line, err);
+            continue;
         }
+        *out++ = std::move(obj);
+        count++;
     }
     return count;
 }
 
-RWString escapeJSONString(const ROString & input)
-{
-    size_t count = computeJSONStringRequiredSize(input);
-    RWString ret(0, count);
-    char * o = (char*)ret.getData();
-    static char hexDigits[] = "0123456789abcdef";
-    const char * p = input.getData();
-    for (size_t i = 0; i < input.getLength(); i++) {
-        switch (p[i]) {
-        case '"': *o++ = '\\'; *o++ = '"';   break;
-        case '\\': *o++ = '\\'; *o++ = '\\'; break;
-        case '\b': *o++ = '\\'; *o++ = 'b'; break;
-        case '\f': *o++ = '\\'; *o++ = 'f'; break;
-        case '\n': *o++ = '\\'; *o++ = 'n'; break;
-        case '\r': *o++ = '\\'; *o++ = 'r'; break;
-        case '\t': *o++ = '\\'; *o++ = 't'; break;
-        default:
-            if ((uint8)p[i] <= '\x1f') {
-                *o++ = '\\'; *o++ = 'u'; *o++ = '0'; *o++ = '0';
-                *o++ = hexDigits[p[i] >> 4]; *o++ = hexDigits[p[i] & 0xF];
-            } else {
-                *o++ = p[i];
-            }
-        }
+/** Deserialize newline delimited JSON, skipping the records that fail to deserialize.
+    @sa deserializeLines */
+template <class T, class P = Parser, class OutputIt>
+size_t deserializeLines(const ROString & json, OutputIt out)
+{
+    return deserializeLines<T, P>(json, out, [](size_t, ROString) {});
+}
+
+/** Patch the given object with a delta, as produced by serializeDelta.
+    Unlike deserialize, the members that aren't in the JSON text are left untouched, and nested objects are patched
+    recursively. Any other member that's present (including an array) is replaced completely.
+    If an error occurs, the members that were found before it are already patched.
+    @param obj      The object to patch
+    @param json     The delta JSON text
+    @return true on success, the error is logged on failure */
+template <class T, class P = Parser>
+bool applyDelta(T & obj, const ROString & json)
+{
+    static_assert(Details::isNestedObject<T>(), "A delta can only be applied to a reflected struct");
+    P parser(json);
+    RWString err = Details::applyDeltaFromJSON(parser, obj);
+    if (err) return parser.Error(0, err);
+    return true;
+}
+
+#ifdef AllowSerializing
+/** Serialize the given object to the given sink.
+    Only a single pass is done on the object and the output is written to the sink as soon as it's produced.
+    No intermediate string is built so this doesn't allocate anything (unless the sink does)
+    @param obj      The object to serialize
+    @param sink     Any sink (like Tools::DynamicSink, Tools::FixedSink or Tools::CallbackSink)
+    @return true if the sink was able to store the complete output */
+template <class T, Tools::Sink S>
+bool serialize(const T & obj, S & sink)
+{
+    Details::serializeToJSON(sink, obj);
+    return sink.isValid();
+}
+
+/** Serialize the given object and forward the output, chunk by chunk, to the given callback.
+    @return the total size of the output in bytes */
+template <class T>
+size_t serialize(const T & obj, Tools::function_ref<void(ROString)> callback)
+{
+    Tools::CallbackSink sink(callback);
+    Details::serializeToJSON(sink, obj);
+    sink.flush();
+    return sink.getLength();
+}
+
+/** Serialize the given object to a JSON valid string. */
+template <class T>
+RWString serialize(const T & obj)
+{
+    Tools::DynamicSink sink;
+    Details::serializeToJSON(sink, obj);
+    return sink.release();
+}
+
+/** Compute the exact size (in bytes, without the final zero) of the JSON text the serialize function would output.
+    This is a single pass on the object that's not storing anything */
+template <class T>
+size_t serializedSize(const T & obj)
+{
+    Tools::CountingSink sink;
+    Details::serializeToJSON(sink, obj);
+    return sink.getLength();
+}
+
+/** Compute, at compile time, an upper bound for the serialized size of the given type (without the final zero).
+    This is only possible for types whose members are of fixed size (numbers, enums, bools, char[N], fixed arrays,
+    std::array or aggregates of these). Use this to size a static or stack buffer like this:
+    @code
+        char buffer[serializedSizeBound<A>() + 1];
+        ROString json = serialize(a, buffer);
+    @endcode */
+template <class T>
+consteval size_t serializedSizeBound()
+{
+    static_assert(Details::hasBoundedJSONSize<T>(), "This type contains dynamically sized members, its serialized size isn't bounded");
+    return Details::maxJSONSize<T>();
+}
+
+/** Serialize the given object in the given buffer without any heap allocation.
+    The output is zero terminated.
+    @return A view on the output or an empty string if the buffer is too small */
+template <class T>
+ROString serialize(const T & obj, char * buffer, const size_t size)
+{
+    Tools::FixedSink sink(buffer, size);
+    Details::serializeToJSON(sink, obj);
+    return sink.isValid() ? sink.view() : ROString();
+}
+
+/** Serialize the given object in the given fixed size array without any heap allocation.
+    @sa serialize(const T &, char *, const size_t) */
+template <class T, size_t N>
+ROString serialize(const T & obj, char (&buffer)[N]) { return serialize(obj, buffer, N); }
+
+/** Serialize the given object in the given buffer without any heap allocation.
+    @sa serialize(const T &, char *, const size_t) */
+template <class T>
+ROString serialize(const T & obj, std::span<char> buffer) { return serialize(obj, buffer.data(), buffer.size()); }
+
+/** Serialize only the members that changed between two states of an object to the given sink.
+    Members are compared one by one, nested objects recursively, so only the changed keys are written. For example, if
+    only cur.net.rssi changed, the output is {"net":{"rssi":-60}}. If nothing changed, the output is {}.
+    Use applyDelta on the receiving side to patch its copy of the previous state.
+    @return true if the sink was able to store the complete output */
+template <class T, Tools::Sink S>
+bool serializeDelta(const T & prev, const T & cur, S & sink)
+{
+    Details::serializeDeltaToJSON(sink, prev, cur);
+    return sink.isValid();
+}
+
+/** Serialize only the members that changed between two states of an object.
+    @sa serializeDelta(const T &, const T &, S &) */
+template <class T>
+RWString serializeDelta(const T & prev, const T & cur)
+{
+    Tools::DynamicSink sink;
+    Details::serializeDeltaToJSON(sink, prev, cur);
+    return sink.release();
+}
+
+/** A compile time selection of members, by name, used to serialize only a part of an object.
+    @sa serialize(const T &) with a Fields argument */
+template <CompileTime::str ... Names>
+struct Fields
+{
+    /** Get the indices of the selected members in the given type */
+    template <typename T>
+    static constexpr auto indices()
+    {
+        static_assert(((Details::memberIndex<T, Names>() < Details::JSONKeyFragments<T>::count) && ... && true), "No member with this name");
+        return std::index_sequence<Details::memberIndex<T, Names>()...>{};
     }
-    *o = 0;
+};
+
+namespace Details
+{
+    template <typename>                 struct IsFields : std::false_type { };
+    template <CompileTime::str ... N>   struct IsFields<Fields<N...>> : std::true_type { };
+}
+
+/** Serialize only the given members of the object to the given sink, in the given order.
+    Member names are resolved at compile time, so this is as fast as serializing a smaller struct:
+    @code
+        serialize<Fields<"id", "temp", "ts">>(reading, sink);
+    @endcode
+    @return true if the sink was able to store the complete output */
+template <class F, class T, Tools::Sink S>
+    requires(Details::IsFields<F>::value)
+bool serialize(const T & obj, S & sink)
+{
+    Details::serializeSelectedMembers(sink, obj, F::template indices<T>());
+    return sink.isValid();
+}
+
+/** Serialize only the given members of the object to a JSON string.
+    @sa serialize(const T &, S &) with a Fields argument */
+template <class F, class T>
+    requires(Details::IsFields<F>::value)
+RWString serialize(const T & obj)
+{
+    Tools::DynamicSink sink;
+    Details::serializeSelectedMembers(sink, obj, F::template indices<T>());
+    return sink.release();
+}
+
+/** Build, at compile time, the mask of the given members for serializeFields */
+template <class T, CompileTime::str ... Names>
+consteval uint64 fieldMask()
+{
+    static_assert(Details::JSONKeyFragments<T>::count <= 64, "Too many members for a mask");
+    static_assert(((Details::memberIndex<T, Names>() < Details::JSONKeyFragments<T>::count) && ... && true), "No member with this name");
+    return (((uint64)1 << Details::memberIndex<T, Names>()) | ... | 0);
+}
+
+/** Serialize only the members whose bit (by declaration order) is set in the given mask to the given sink.
+    This is the runtime counterpart of Fields, when the selection depends on the request. Build the mask with fieldMask.
+    @return true if the sink was able to store the complete output */
+template <class T, Tools::Sink S>
+bool serializeFields(const T & obj, const uint64 mask, S & sink)
+{
+    static_assert(Details::JSONKeyFragments<T>::count <= 64, "Too many members for a mask");
+    Details::serializeMaskedMembers(sink, obj, mask, std::make_index_sequence<Details::JSONKeyFragments<T>::count>{});
+    return sink.isValid();
+}
+
+/** Serialize only the members whose bit is set in the given mask to a JSON string.
+    @sa serializeFields(const T &, const uint64, S &) */
+template <class T>
+RWString serializeFields(const T & obj, const uint64 mask)
+{
+    Tools::DynamicSink sink;
+    serializeFields(obj, mask, sink);
+    return sink.release();
+}
+#endif
+
+/** Compute the size of the given string once escaped for JSON (without the quotes) */
+inline size_t computeJSONStringRequiredSize(const ROString & input)
+{
+    Tools::CountingSink sink;
+    Details::serializeEscaped(sink, input.getData(), input.getLength());
+    return sink.getLength();
+}
+
+/** Unescape the given JSON string (without its quotes) in the given mutable buffer.
+    Since the decoded text is never larger than the escaped text, this is done in place.
+    @return A view on the decoded text in the buffer, or an empty string on invalid escape sequence */
+inline ROString unescapeJSONStringInPlace(char * buffer, const size_t len)
+{
+    size_t res = Details::unescapeJSON(buffer, len, buffer, len);
+    return res == (size_t)-1 ? ROString() : ROString(buffer, (int)res);
+}
+
+/** Unescape the given JSON string (without its quotes).
+    @return The decoded text or an empty string on invalid escape sequence */
+inline RWString unescapeJSONString(const ROString & input)
+{
+    if (!memchr(input.getData(), '\\', input.getLength())) return input;
+    RWString ret(0, input.getLength());
+    size_t res = Details::unescapeJSON(input.getData(), input.getLength(), ret.map(), input.getLength());
+    if (res == (size_t)-1) return RWString();
+    ret.limitTo(res).map()[res] = 0;
     return ret;
 }
 
+/** Escape the given string so it respects the JSON format (without adding the quotes).
+    This is done in a single pass, the clean runs of chars are found with a vectorized search and copied at once */
+inline RWString escapeJSONString(const ROString & input)
+{
+    Tools::DynamicSink sink(input.getLength() + input.getLength() / 8);
+    Details::serializeEscaped(sink, input.getData(), input.getLength());
+    return sink.release();
+}
+
 
 #endif
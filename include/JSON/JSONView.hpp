@@ -0,0 +1,208 @@
+#ifndef hpp_JSONView_hpp
+#define hpp_JSONView_hpp
+
+// We need the reflection based deserializer for the complex values
+#include "JSONSerdes.hpp"
+
+/** A lazy view on a JSON value.
+    Nothing is parsed when the view is built. Accessing a member or an element only scans the text from the current
+    position up to the requested value (uninteresting values are skipped with the structural scanner) and returns a
+    view on it. Accesses in document order are thus done in a single forward pass. This is useful for handlers that
+    only need a few fields, or that must check a field before deciding what to do with the rest of the document.
+    For example:
+    @code
+        JSONView doc(json);
+        if (doc["type"].getString() == "reading")
+        {
+            double value = doc["value"].as<double>();
+            Reading r; doc["details"].get(r);
+        }
+    @endcode
+    The view doesn't allocate and only stores a small cursor. It doesn't validate the text either: an invalid document
+    gives invalid (or missing) values, but never reads out of the given buffer.
+    Object keys are compared without unescaping. */
+class JSONView
+{
+public:
+    /** The type of the value */
+    enum Type
+    {
+        Invalid = 0,    //!< Missing value (or not a JSON value)
+        Object,
+        Array,
+        String,
+        Number,
+        Bool,
+        Null,
+    };
+
+    // Members
+private:
+    /** The JSON text (the view doesn't own it) */
+    const char *    data;
+    /** The JSON text length */
+    size_t          len;
+    /** The position of the first char of this value (len if invalid) */
+    size_t          pos;
+    /** For containers, the position in the content where the next lookup starts */
+    size_t          cursor;
+    /** For arrays, the index of the element at the cursor */
+    size_t          index;
+    /** For objects, set if the cursor is on the value of the last found member instead of a key */
+    bool            atValue;
+
+    // Helpers
+private:
+    size_t skipWhitespace(const size_t p) const { return JSONScan::skipWhitespace(data, len, p); }
+    /** Skip the value at the given position and its trailing comma. @return the position of the next item */
+    size_t nextItem(size_t p) const
+    {
+        const size_t end = JSONScan::skipValue(data, len, p);
+        if (end == p) return len; // Not a value, so the text is invalid
+        p = skipWhitespace(end);
+        return p < len && data[p] == ',' ? skipWhitespace(p + 1) : p;
+    }
+    /** Get the position right after the closing quote of the string at the given position, or 0 if it isn't terminated.
+        The scanner returns the text length for both a string ending the text and an unterminated one, so the last
+        quote is checked here (it must not be the opening quote, nor be escaped) */
+    size_t stringEnd(const size_t p) const
+    {
+        const size_t end = JSONScan::skipString(data, len, p + 1);
+        if (end < len) return end;
+        if (end - p < 2 || data[end - 1] != '"') return 0;
+        size_t escapes = 0;
+        while (end - 2 - escapes > p && data[end - 2 - escapes] == '\\') escapes++;
+        return escapes & 1 ? 0 : end;
+    }
+    /** The position of the first item in this container */
+    size_t firstItem() const { return skipWhitespace(pos + 1); }
+
+    JSONView(const char * data, const size_t len, const size_t pos) : data(data), len(len), pos(pos), cursor(pos + 1), index(0), atValue(false) {}
+
+    // Interface
+public:
+    /** Get the type of this value */
+    Type getType() const
+    {
+        if (pos >= len) return Invalid;
+        switch (data[pos])
+        {
+        case '{': return Object;
+        case '[': return Array;
+        case '"': return String;
+        case 't': case 'f': return Bool;
+        case 'n': return Null;
+        case '-': return Number;
+        default: return (unsigned)(data[pos] - '0') < 10 ? Number : Invalid;
+        }
+    }
+    bool isValid() const    { return getType() != Invalid; }
+    bool isObject() const   { return getType() == Object; }
+    bool isArray() const    { return getType() == Array; }
+    bool isString() const   { return getType() == String; }
+    bool isNumber() const   { return getType() == Number; }
+    bool isBool() const     { return getType() == Bool; }
+    bool isNull() const     { return getType() == Null; }
+    explicit operator bool() const { return isValid(); }
+
+    /** Get the JSON text of this value (including the quotes for a string, or the brackets for a container) */
+    ROString raw() const { return pos < len ? ROString(data + pos, (int)(JSONScan::skipValue(data, len, pos) - pos)) : ROString(); }
+    /** Get the text of a string value, without its quotes. Escape sequences are kept as is (use get to unescape them)
+        @return An empty string if this isn't a string */
+    ROString getString() const
+    {
+        if (!isString()) return ROString();
+        const size_t end = stringEnd(pos);
+        return end ? ROString(data + pos + 1, (int)(end - pos - 2)) : ROString();
+    }
+
+    /** Get the number of members or elements in this container (this scans the complete container) */
+    size_t size() const
+    {
+        if (!isObject() && !isArray()) return 0;
+        const size_t p = firstItem();
+        return p >= len || data[p] == ']' || data[p] == '}' ? 0 : JSONScan::countArrayElements(data, len, p);
+    }
+
+    /** Find the member with the given key in this object.
+        The search starts after the last found member and wraps around, so accessing the members in the document order
+        only scans the object once.
+        @return An invalid view if this isn't an object or the key isn't found */
+    JSONView operator[](const ROString & key)
+    {
+        if (!isObject()) return JSONView();
+        const size_t start = firstItem(), first = atValue ? nextItem(cursor) : skipWhitespace(cursor);
+        bool wrapped = false;
+        // Once wrapped, stop when coming back to the first checked member
+        for (size_t p = first; !wrapped || p < first; )
+        {
+            if (p >= len || data[p] != '"')
+            {   // End of object, restart from its beginning once (unless the search started there)
+                if (wrapped || first == start) break;
+                wrapped = true; p = start;
+                continue;
+            }
+            const size_t end = JSONScan::skipString(data, len, p + 1);
+            const bool match = end < len && end - p - 2 == key.getLength() && !memcmp(data + p + 1, key.getData(), key.getLength());
+            p = skipWhitespace(end);
+            if (p >= len || data[p] != ':') break;
+            p = skipWhitespace(p + 1);
+            if (match) { cursor = p; atValue = true; return JSONView(data, len, p); }
+            p = nextItem(p);
+        }
+        return JSONView();
+    }
+
+    /** Get the element at the given index in this array.
+        Accessing the elements in increasing order only scans the array once, going back restarts from its beginning.
+        @return An invalid view if this isn't an array or the index is out of range */
+    JSONView operator[](const size_t i)
+    {
+        if (!isArray()) return JSONView();
+        if (i < index || cursor == pos + 1) { cursor = firstItem(); index = 0; }
+        while (index < i && cursor < len && data[cursor] != ']') { cursor = nextItem(cursor); index++; }
+        if (cursor >= len || data[cursor] == ']') return JSONView();
+        return JSONView(data, len, cursor);
+    }
+
+    /** Get this value in the given object.
+        Numbers and booleans are decoded directly, other types (strings, containers and reflected structs) are
+        deserialized with the given parser.
+        @return true on success */
+    template <typename T, typename P = Parser>
+    bool get(T & out) const
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            const ROString text = raw();
+            if (text == "true") out = true;
+            else if (text == "false") out = false;
+            else return false;
+            return true;
+        }
+        else if constexpr (std::is_arithmetic_v<T>)
+            return isNumber() && JSONNumber::parse(raw(), out) == JSONNumber::Ok;
+        else
+        {
+            if (!isValid()) return false;
+            P parser(raw());
+            RWString err = Details::deserializeFromJSON(parser, out);
+            if (err) return parser.Error(0, err);
+            return true;
+        }
+    }
+    /** Get this value or the given default value if it's missing or can't be converted */
+    template <typename T, typename P = Parser>
+    T as(const T & defaultValue = T()) const
+    {
+        T out{};
+        return get<T, P>(out) ? out : defaultValue;
+    }
+
+    /** Build a view on the given JSON text (the text must outlive the view) */
+    JSONView(const ROString & json) : JSONView(json.getData(), json.getLength(), JSONScan::skipWhitespace(json.getData(), json.getLength(), 0)) {}
+    /** Build an invalid view */
+    JSONView() : data(0), len(0), pos(0), cursor(0), index(0), atValue(false) {}
+};
+
+#endif
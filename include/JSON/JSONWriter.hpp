@@ -0,0 +1,253 @@
+#ifndef hpp_JSONWriter_hpp
+#define hpp_JSONWriter_hpp
+
+// We need the reflection based serializer
+#include "JSONSerdes.hpp"
+
+#ifdef AllowSerializing
+
+namespace Details
+{
+    /** Compute the maximum nesting depth of the JSON output for the given type (a basic type has a depth of 1) */
+    template <typename U>
+    consteval size_t jsonDepth()
+    {
+        using T = std::remove_cv_t<U>;
+        if constexpr (isBasicType<std::decay_t<T>>() || is_base64_bytes_v<T>) return 1;
+        else if constexpr (std::is_array_v<T>) return 1 + jsonDepth<std::remove_extent_t<T>>();
+        else if constexpr (is_std_container_v<T>) return 1 + jsonDepth<typename T::value_type>();
+        else
+        {
+            using Members = typename JSONKeyFragments<T>::Members;
+            return 1 + []<size_t ... Ix>(std::index_sequence<Ix...>)
+            {
+                size_t depth = 0;
+                ((depth = std::max(depth, jsonDepth<typename std::tuple_element_t<Ix, Members>::template type<>>())), ...);
+                return depth;
+            }(std::make_index_sequence<std::tuple_size_v<Members>>{});
+        }
+    }
+}
+
+/** A pull based JSON serializer.
+    Unlike the serialize function, this doesn't need to store the complete output anywhere. Instead, you ask for the next
+    part of the output by providing a (small) buffer to fill. When the buffer is full, the writer suspends and it'll
+    resume exactly where it stopped (mid-array, mid-string) on the next call.
+    This is done without any allocation: the writer only remembers its position at each nesting level (this is computed
+    at compile time from the type) and the number of bytes already output for the current token.
+
+    Typical usage:
+    @code
+        JSONWriter writer(hugeObject);
+        char window[1024];
+        while (size_t len = writer.next(window))
+            socket.send(window, len);
+    @endcode
+    @warning The object must not be modified while it's being written */
+template <typename T>
+class JSONWriter
+{
+    // Members
+private:
+    /** The object to serialize */
+    const T &       obj;
+    /** The position in each nesting level. This is (index * 2 + phase), where phase is 0 while writing the
+        separator (or key) before the index-th child and 1 while writing the child itself */
+    size_t          steps[Details::jsonDepth<T>()];
+    /** The number of bytes of the current token that were already output */
+    size_t          offset;
+    /** The position in the current string plus one (0 means the opening quote isn't written yet) */
+    size_t          strPos;
+    /** The output buffer for the current call */
+    char *          out;
+    /** The output buffer size and used size for the current call */
+    size_t          size, used;
+    /** Set when the complete object was output */
+    bool            done;
+
+    // Helpers
+private:
+    /** Write a token made of the given parts, skipping what was already written in a previous call.
+        @return true if the token was completely written, false if the output buffer is full */
+    template <typename ... Parts>
+    bool token(const Parts & ... parts)
+    {
+        size_t pos = 0;
+        auto write = [this, &pos](const ROString & part)
+        {
+            size_t len = part.getLength();
+            if (pos + len <= offset) { pos += len; return true; }
+            size_t skip = offset > pos ? offset - pos : 0, c = min(len - skip, size - used);
+            memcpy(out + used, part.getData() + skip, c);
+            used += c; pos += skip + c; offset = pos;
+            return skip + c == len;
+        };
+        if (!(write(parts) && ...)) return false;
+        offset = 0;
+        return true;
+    }
+
+    /** Write a quoted and escaped string.
+        Clean runs of chars are accounted for in the string position directly, so resuming never scans the string again */
+    bool emitString(const char * str, const size_t len)
+    {
+        if (!strPos)
+        {
+            if (!token(ROString("\""))) return false;
+            strPos = 1;
+        }
+        while (strPos - 1 < len)
+        {
+            const char * p = str + strPos - 1;
+            if (!offset)
+            {
+                if (used == size) return false;
+                size_t clean = Details::findJSONEscape(p, min(len - (strPos - 1), size - used));
+                memcpy(out + used, p, clean);
+                used += clean; strPos += clean;
+                if (clean) continue;
+            }
+            char esc[6];
+            if (!token(ROString(esc, (int)Details::escapeJSONChar(*p, esc)))) return false;
+            strPos++;
+        }
+        if (!token(ROString("\""))) return false;
+        strPos = 0;
+        return true;
+    }
+
+    /** Write a quoted base64 string.
+        Complete 3 bytes groups are encoded straight to the output, and a group that doesn't fit is written as a token,
+        so it resumes mid group. The string position counts the input bytes here */
+    bool emitBase64(const uint8 * data, const size_t len)
+    {
+        if (!strPos)
+        {
+            if (!token(ROString("\""))) return false;
+            strPos = 1;
+        }
+        while (strPos - 1 < len)
+        {
+            const uint8 * p = data + strPos - 1;
+            if (!offset)
+            {
+                const size_t groups = min((len - (strPos - 1)) / 3, (size - used) / 4);
+                if (groups)
+                {
+                    used += Tools::Base64::encode(p, groups * 3, out + used);
+                    strPos += groups * 3;
+                    continue;
+                }
+            }
+            char group[4];
+            const size_t n = min(len - (strPos - 1), (size_t)3);
+            Tools::Base64::encode(p, n, group);
+            if (!token(ROString(group, 4))) return false;
+            strPos += n;
+        }
+        if (!token(ROString("\""))) return false;
+        strPos = 0;
+        return true;
+    }
+
+    /** Write a basic type */
+    template <typename U>
+    bool emitBasic(const U & t)
+    {
+        using V = std::decay_t<U>;
+        if constexpr (Details::is_bounded_char_array_v<U>) return emitString(t, strnlen(t, sizeof(t)));
+        else if constexpr (std::is_same_v<V, RWString> || std::is_same_v<V, ROString> || std::is_same_v<V, ArenaString>) return emitString(t.getData(), t.getLength());
+        else if constexpr (std::is_same_v<V, std::string> || std::is_same_v<V, std::string_view>) return emitString(t.data(), t.length());
+        else if constexpr (std::is_convertible_v<V, const char *> && !std::is_arithmetic_v<V>) return emitString((const char*)t, t ? strlen((const char*)t) : 0);
+        else
+        {
+            // Numbers, enums and bools are short enough to be formatted in a stack buffer
+            char buf[Details::maxJSONSize<V>() + 1];
+            Tools::FixedSink sink(buf);
+            Details::serializeBasicType(sink, t);
+            return token(sink.view());
+        }
+    }
+
+    /** Write the given member of an aggregate (and the key preceding it) */
+    template <size_t Ix, typename U>
+    bool emitMember(const U & t, const size_t depth)
+    {
+        using Keys = Details::JSONKeyFragments<U>;
+        size_t & step = steps[depth];
+        if (step / 2 > Ix) return true;
+        if (!(step & 1))
+        {
+            if (!token(Keys::template fragment<Ix>())) return false;
+            step++; steps[depth + 1] = 0;
+        }
+        if (!emit(std::tuple_element_t<Ix, typename Keys::Members>::get(t), depth + 1)) return false;
+        step++;
+        return true;
+    }
+
+    /** Write any value at the given depth */
+    template <typename U>
+    bool emit(const U & t, const size_t depth)
+    {
+        using V = std::decay_t<U>;
+        if constexpr (Details::is_base64_bytes_v<U>) return emitBase64((const uint8*)std::data(t), std::size(t));
+        else if constexpr (Details::isBasicType<V>()) return emitBasic(t);
+        else if constexpr (Details::is_std_container_v<V> || std::is_array_v<U>)
+        {
+            const size_t count = std::size(t);
+            size_t & step = steps[depth];
+            while (step / 2 < count)
+            {
+                const size_t i = step / 2;
+                if (!(step & 1))
+                {
+                    if (!token(ROString(i ? "," : "[", 1))) return false;
+                    step++; steps[depth + 1] = 0;
+                }
+                if (!emit(t[i], depth + 1)) return false;
+                step++;
+            }
+            return token(count ? ROString("]") : ROString("[]"));
+        }
+        else if constexpr (std::is_aggregate_v<V>)
+        {
+            using Keys = Details::JSONKeyFragments<V>;
+            bool complete = [&]<size_t ... Ix>(std::index_sequence<Ix...>) { return (emitMember<Ix>(t, depth) && ... && true); }(std::make_index_sequence<Keys::count>{});
+            return complete && token(Keys::count ? ROString("}") : ROString("{}"));
+        }
+        else
+        {
+            static_assert(Refl::always_false_v<V>, "Can't serialize this type to JSON");
+            return false;
+        }
+    }
+
+    // Interface
+public:
+    /** Fill the given buffer with the next part of the JSON output.
+        @param buffer   The output buffer. It's not zero terminated.
+        @return The number of bytes written to the buffer, 0 once the complete output was written */
+    size_t next(std::span<char> buffer)
+    {
+        if (done || !buffer.size()) return 0;
+        out = buffer.data(); size = buffer.size(); used = 0;
+        done = emit(obj, 0);
+        return used;
+    }
+    /** Fill the given buffer with the next part of the JSON output */
+    template <size_t N>
+    size_t next(char (&buffer)[N]) { return next(std::span<char>(buffer, N)); }
+
+    /** Check if the complete output was written */
+    bool isDone() const { return done; }
+    /** Restart writing from the beginning */
+    void restart() { steps[0] = 0; offset = 0; strPos = 0; done = false; }
+
+    /** Build a writer for the given object. The object must outlive the writer */
+    JSONWriter(const T & obj) : obj(obj), steps{}, offset(0), strPos(0), out(0), size(0), used(0), done(false) {}
+};
+
+#endif
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef hpp_Arena_hpp
+#define hpp_Arena_hpp
+
+// We need basic types
+#include "Types.hpp"
+#include <stdlib.h>
+#include <stddef.h>
+#include <new>
+#include <type_traits>
+
+namespace Tools
+{
+    /** A bump allocator.
+        Allocation is only moving a pointer forward in the current block, and all allocations are released at once when
+        the arena is reset or destructed. There is no way to release a single allocation.
+
+        The arena can start with a caller provided buffer (typically on stack) and, if allowed, it'll allocate new blocks
+        on the heap when the buffer is exhausted. Each new block is twice as large as the previous one, so the number of
+        heap allocation is logarithmic in the total size. */
+    struct BumpArena
+    {
+        /** The header of each heap allocated block */
+        struct Block
+        {
+            Block * next;
+            size_t  size;
+        };
+
+        /** The current chunk we are allocating from */
+        char *  current;
+        /** The current chunk size and used size in bytes */
+        size_t  size, used;
+        /** The heap blocks (the last allocated first) */
+        Block * blocks;
+        /** The size of the next heap block to allocate, or 0 if heap allocation is forbidden */
+        size_t  nextBlockSize;
+        /** The initial buffer (if any) */
+        char *  initial;
+        size_t  initialSize;
+
+        /** Allocate the given size with the given alignment.
+            @return A pointer to the allocated memory or 0 if the arena is exhausted */
+        void * allocate(const size_t bytes, const size_t align = alignof(max_align_t))
+        {
+            size_t pad = current ? (size_t)(-(uintptr_t)(current + used) & (align - 1)) : 0;
+            if (!current || used + pad + bytes > size)
+            {
+                if (!nextBlockSize) return 0;
+                size_t blockSize = nextBlockSize;
+                while (blockSize < bytes + align + sizeof(Block)) blockSize *= 2;
+                Block * block = (Block*)::malloc(blockSize);
+                if (!block) return 0;
+                block->next = blocks; block->size = blockSize; blocks = block;
+                current = (char*)(block + 1); size = blockSize - sizeof(Block); used = 0;
+                nextBlockSize = blockSize * 2;
+                pad = (size_t)(-(uintptr_t)current & (align - 1));
+            }
+            void * ret = current + used + pad;
+            used += pad + bytes;
+            return ret;
+        }
+
+        /** Allocate an array of the given type (the items are not constructed) */
+        template <typename T>
+        T * allocateArray(const size_t count) { return (T*)allocate(count * sizeof(T), alignof(T)); }
+
+        /** Release all allocations at once. Only the heap blocks are freed, the initial buffer is reused */
+        void reset()
+        {
+            size_t largest = 0;
+            while (blocks) { Block * n = blocks->next; largest = max(largest, blocks->size); ::free(blocks); blocks = n; }
+            if (nextBlockSize && largest) nextBlockSize = largest;
+            current = initial; size = initialSize; used = 0;
+        }
+
+        /** Get the number of bytes allocated from the current chunk */
+        size_t getUsed() const { return used; }
+
+        /** Allocate a dedicated heap block for a single allocation, even if the arena isn't allowed to grow.
+            The block is owned by the arena and released with it, but it's never allocated from again.
+            @return A pointer to the allocated memory or 0 if the heap is exhausted */
+        void * allocateBlock(const size_t bytes, const size_t align = alignof(max_align_t))
+        {
+            Block * block = (Block*)::malloc(sizeof(Block) + bytes + align);
+            if (!block) return 0;
+            // The current chunk doesn't change, so the next allocations still come from it
+            block->next = blocks; block->size = sizeof(Block) + bytes + align; blocks = block;
+            char * p = (char*)(block + 1);
+            return p + (size_t)(-(uintptr_t)p & (align - 1));
+        }
+
+        /** Build an arena that's only allocating from the heap, starting with the given block size */
+        explicit BumpArena(const size_t firstBlockSize = 1024) : current(0), size(0), used(0), blocks(0), nextBlockSize(firstBlockSize), initial(0), initialSize(0) {}
+        /** Build an arena that's allocating from the given buffer first.
+            @param buffer           The initial buffer to allocate from
+            @param bufferSize       The initial buffer size in bytes
+            @param allowHeap        If true, when the buffer is exhausted, new blocks are allocated on the heap */
+        BumpArena(char * buffer, const size_t bufferSize, const bool allowHeap = false)
+            : current(buffer), size(bufferSize), used(0), blocks(0), nextBlockSize(allowHeap ? max(bufferSize * 2, (size_t)256) : 0), initial(buffer), initialSize(bufferSize) {}
+        /** Build an arena that's allocating from the given array first */
+        template <size_t N>
+        BumpArena(char (&buffer)[N], const bool allowHeap = false) : BumpArena(buffer, N, allowHeap) {}
+        ~BumpArena() { reset(); }
+        BumpArena(const BumpArena &) = delete;
+        BumpArena & operator = (const BumpArena &) = delete;
+    };
+
+    /** A standard allocator allocating from a bump arena, so containers can be released at once with the arena.
+        Deallocation does nothing, so a growing container wastes its previous storage: reserve the final size first.
+        If the arena is exhausted, the storage comes from a dedicated heap block that's owned by the arena (and released
+        with it), so the container is always usable. Without arena, this is a plain heap allocator.
+        Which case applies only depends on the allocator's state, never on the memory itself, so deallocating storage
+        that's stale after its arena was reset doesn't touch it. */
+    template <typename T>
+    struct ArenaAllocator
+    {
+        typedef T value_type;
+        // The allocator follows the storage
+        typedef std::true_type propagate_on_container_copy_assignment;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        /** The arena to allocate from (can be null) */
+        BumpArena * arena;
+
+        T * allocate(const size_t n)
+        {
+            if (!arena) return (T*)::operator new(n * sizeof(T));
+            if (T * p = arena->allocateArray<T>(n)) return p;
+            if (T * p = (T*)arena->allocateBlock(n * sizeof(T), alignof(T))) return p;
+#if defined(__cpp_exceptions)
+            throw std::bad_alloc();
+#else
+            abort();
+#endif
+        }
+        /** The arena's memory is only released with the arena */
+        void deallocate(T * p, const size_t)
+        {
+            if (!arena) ::operator delete(p);
+        }
+
+        bool operator == (const ArenaAllocator & other) const { return arena == other.arena; }
+        bool operator != (const ArenaAllocator & other) const { return arena != other.arena; }
+
+        ArenaAllocator(BumpArena * arena = 0) : arena(arena) {}
+        template <typename U> ArenaAllocator(const ArenaAllocator<U> & other) : arena(other.arena) {}
+    };
+
+    template <typename>     struct IsArenaAllocator : std::false_type { };
+    template <typename T>   struct IsArenaAllocator<ArenaAllocator<T>> : std::true_type { };
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef hpp_Base64_hpp
+#define hpp_Base64_hpp
+
+// We need basic types
+#include "Types.hpp"
+// We need sinks for the streaming encoder
+#include "Sinks.hpp"
+
+namespace Tools
+{
+    /** Base64 encoding and decoding (RFC 4648, standard alphabet with padding).
+        Both directions work on a machine word at a time: 6 input bytes are packed in a 64 bits integer and split in
+        8 sextets (and back), so there's no per char branch, and invalid chars are detected by accumulating a flag. */
+    namespace Base64
+    {
+        static constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        /** The reverse table, with 0x80 for invalid chars */
+        struct ReverseTable
+        {
+            uint8 v[256];
+            consteval ReverseTable() : v{}
+            {
+                for (auto & c : v) c = 0x80;
+                for (uint8 i = 0; i < 64; i++) v[(uint8)alphabet[i]] = i;
+            }
+        };
+        static constexpr ReverseTable reverse{};
+
+        /** Get the encoded size (with padding) for the given amount of bytes */
+        constexpr size_t encodedSize(const size_t len) { return (len + 2) / 3 * 4; }
+        /** Get the maximum decoded size for the given encoded length */
+        constexpr size_t decodedSize(const size_t len) { return (len + 3) / 4 * 3; }
+
+        /** Encode the given bytes.
+            @param out  The output buffer, that must be at least encodedSize(len) bytes
+            @return The number of chars written */
+        inline size_t encode(const uint8 * in, const size_t len, char * out)
+        {
+            size_t i = 0, o = 0;
+            for (; i + 6 <= len; i += 6, o += 8)
+            {
+                const uint64 v = ((uint64)in[i] << 40) | ((uint64)in[i+1] << 32) | ((uint64)in[i+2] << 24) | ((uint64)in[i+3] << 16) | ((uint64)in[i+4] << 8) | in[i+5];
+                for (int k = 0; k < 8; k++) out[o + k] = alphabet[(v >> (42 - 6 * k)) & 63];
+            }
+            for (; i + 3 <= len; i += 3, o += 4)
+            {
+                const uint32 v = ((uint32)in[i] << 16) | ((uint32)in[i+1] << 8) | in[i+2];
+                out[o] = alphabet[v >> 18]; out[o+1] = alphabet[(v >> 12) & 63]; out[o+2] = alphabet[(v >> 6) & 63]; out[o+3] = alphabet[v & 63];
+            }
+            if (i < len)
+            {
+                const uint32 v = ((uint32)in[i] << 16) | (i + 1 < len ? (uint32)in[i+1] << 8 : 0);
+                out[o] = alphabet[v >> 18]; out[o+1] = alphabet[(v >> 12) & 63];
+                out[o+2] = i + 1 < len ? alphabet[(v >> 6) & 63] : '=';
+                out[o+3] = '=';
+                o += 4;
+            }
+            return o;
+        }
+
+        /** Encode the given bytes to the given sink (through a small stack buffer) */
+        template <Sink S>
+        void encode(S & out, const uint8 * in, size_t len)
+        {
+            char buffer[256];
+            const size_t chunk = sizeof(buffer) / 4 * 3;
+            for (; len > chunk; in += chunk, len -= chunk) out.write(buffer, encode(in, chunk, buffer));
+            out.write(buffer, encode(in, len, buffer));
+        }
+
+        /** Decode the given text (padding is optional).
+            @param out      The output buffer
+            @param outSize  The output buffer size in bytes (decodedSize(len) is always enough)
+            @return The number of bytes decoded or (size_t)-1 if the text is invalid or the output buffer too small */
+        inline size_t decode(const char * in, size_t len, uint8 * out, const size_t outSize)
+        {
+            if (len % 4 == 0 && len && in[len - 1] == '=') len -= in[len - 2] == '=' ? 2 : 1;
+            if (len % 4 == 1) return (size_t)-1;
+            const size_t size = len / 4 * 3 + (len % 4 ? len % 4 - 1 : 0);
+            if (size > outSize) return (size_t)-1;
+
+            const uint8 * s = (const uint8*)in;
+            size_t i = 0, o = 0;
+            uint8 err = 0;
+            for (; i + 8 <= len; i += 8, o += 6)
+            {
+                uint64 v = 0;
+                for (int k = 0; k < 8; k++) { const uint8 d = reverse.v[s[i + k]]; err |= d; v = (v << 6) | d; }
+                for (int k = 0; k < 6; k++) out[o + k] = (uint8)(v >> (40 - 8 * k));
+            }
+            // Remaining chars (less than 8)
+            uint32 v = 0; size_t n = 0;
+            for (; i < len; i++)
+            {
+                const uint8 d = reverse.v[s[i]]; err |= d;
+                v = (v << 6) | d;
+                if (++n == 4) { out[o++] = (uint8)(v >> 16); out[o++] = (uint8)(v >> 8); out[o++] = (uint8)v; v = 0; n = 0; }
+            }
+            if (n == 2) out[o++] = (uint8)(v >> 4);
+            else if (n == 3) { out[o++] = (uint8)(v >> 10); out[o++] = (uint8)(v >> 2); }
+            return err & 0x80 ? (size_t)-1 : o;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef hpp_ByteScan_hpp
+#define hpp_ByteScan_hpp
+
+// We need basic types
+#include "Types.hpp"
+
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  #include <arm_neon.h>
+#endif
+
+namespace Tools
+{
+    namespace Scan
+    {
+        /** Repeat the given byte in a machine word */
+        template <typename W> constexpr W repeatByte(const uint8 c) { return (W)((W)~(W)0 / 0xFF) * c; }
+
+        /** Check if any byte in the given word is zero (SWAR). Bytes above the first zero byte might be wrongly flagged */
+        template <typename W> constexpr W zeroBytes(const W x) { return (x - repeatByte<W>(0x01)) & ~x & repeatByte<W>(0x80); }
+
+        /** Check the bytes of the given word that are either one of the given chars or below the given limit (SWAR).
+            The limit must be lower or equal to 0x80 */
+        template <uint8 below, char ... Chars, typename W>
+        constexpr W matchingBytes(const W x)
+        {
+            W m = (zeroBytes<W>(x ^ repeatByte<W>((uint8)Chars)) | ... | 0);
+            if constexpr (below != 0) m |= (x - repeatByte<W>(below)) & ~x & repeatByte<W>(0x80);
+            return m;
+        }
+
+        /** The scalar version of the match, used for the head and the tail of the buffer */
+        template <uint8 below, char ... Chars>
+        constexpr bool matchByte(const char c) { return ((c == Chars) || ... || false) || (uint8)c < below; }
+    }
+
+    /** Find the first byte in the given buffer that's either one of the given chars or strictly lower than the given limit.
+        This is a vectorized search (using SSE2 or NEON when available, or by processing a machine word at a time otherwise).
+        For example, to find the first char requiring escaping in a JSON string:
+        @code
+            size_t pos = Tools::findFirstOf<0x20, '"', '\\'>(text, len);
+        @endcode
+        @param data     The buffer to search into
+        @param len      The buffer size in bytes
+        @return the position of the first matching byte, or len if not found */
+    template <uint8 below, char ... Chars>
+    inline size_t findFirstOf(const char * data, const size_t len)
+    {
+        static_assert(below <= 0x80, "The lower limit must be ASCII");
+        size_t i = 0;
+#if defined(__SSE2__)
+        for (; i + 16 <= len; i += 16)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+            __m128i m = _mm_setzero_si128();
+            ((m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(Chars)))), ...);
+            if constexpr (below != 0) m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8((char)(below - 1))), v));
+            if (int mask = _mm_movemask_epi8(m)) return i + (size_t)__builtin_ctz((unsigned)mask);
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        for (; i + 16 <= len; i += 16)
+        {
+            uint8x16_t v = vld1q_u8((const uint8_t*)(data + i));
+            uint8x16_t m = vdupq_n_u8(0);
+            ((m = vorrq_u8(m, vceqq_u8(v, vdupq_n_u8((uint8)Chars)))), ...);
+            if constexpr (below != 0) m = vorrq_u8(m, vcltq_u8(v, vdupq_n_u8(below)));
+            if (vmaxvq_u8(m)) break;
+        }
+#else
+        typedef size_t Word;
+        for (; i + sizeof(Word) <= len; i += sizeof(Word))
+        {
+            Word w; memcpy(&w, data + i, sizeof(w));
+            if (Scan::matchingBytes<below, Chars...>(w)) break;
+        }
+#endif
+        for (; i < len; i++)
+            if (Scan::matchByte<below, Chars...>(data[i])) return i;
+        return len;
+    }
+}
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef hpp_Sinks_hpp
+#define hpp_Sinks_hpp
+
+// We need basic types
+#include "Types.hpp"
+// We need read only and read write strings
+#include "Strings/ROString.hpp"
+#include "Strings/RWString.hpp"
+// We need function reference for callback sinks
+#include "Tools/FuncRef.hpp"
+#include <concepts>
+
+namespace Tools
+{
+    /** A sink is an output where a producer (typically a serializer) writes its output.
+        The producer only writes to the sink, it never reads back what was written, so it's possible to write directly
+        to a socket, a file or a fixed size buffer without any intermediate allocation.
+
+        A sink must provide these methods:
+        - write(const char * data, size_t len) to append the given data
+        - put(char c) to append a single char
+        - getLength() that returns the number of bytes the producer has written so far (even if they did not fit)
+        - isValid() that returns false if the output was truncated or failed */
+    template <typename S>
+    concept Sink = requires(S & s, const S & cs, const char * data, size_t len, char c)
+    {
+        s.write(data, len);
+        s.put(c);
+        { cs.getLength() } -> std::convertible_to<size_t>;
+        { cs.isValid() } -> std::convertible_to<bool>;
+    };
+
+    /** A growable heap buffer that's doubling its capacity when full.
+        Once done, the buffer is given to a RWString without any copy */
+    struct DynamicSink
+    {
+        char *  buffer;
+        size_t  length;
+        size_t  capacity;
+        bool    failed;
+
+        /** Make sure the buffer can contain the given amount of bytes (plus the final zero) */
+        bool reserve(size_t required)
+        {
+            if (required + 1 <= capacity) return !failed;
+            if (failed) return false;
+            size_t newCap = capacity ? capacity : 64;
+            while (newCap < required + 1) newCap *= 2;
+            char * t = (char*)::realloc(buffer, newCap);
+            if (!t) { failed = true; return false; }
+            buffer = t; capacity = newCap;
+            return true;
+        }
+
+        void write(const char * data, size_t len) { if (!reserve(length + len)) return; memcpy(buffer + length, data, len); length += len; }
+        void put(const char c)                    { if (!reserve(length + 1)) return; buffer[length++] = c; }
+        size_t getLength() const                  { return length; }
+        bool isValid() const                      { return !failed; }
+
+        /** Give the accumulated buffer to a RWString (no copy done here). The sink is empty after this call */
+        RWString release()
+        {
+            RWString ret;
+            if (failed || !reserve(length)) { reset(); return ret; }
+            buffer[length] = 0;
+            ret.capture(buffer, length);
+            buffer = 0; length = 0; capacity = 0;
+            return ret;
+        }
+        /** Drop any accumulated data */
+        void reset() { free0(buffer); length = 0; capacity = 0; failed = false; }
+
+        /** Build a sink with an optional initial capacity to avoid reallocating if the output size is known beforehand */
+        DynamicSink(const size_t initialCapacity = 0) : buffer(0), length(0), capacity(0), failed(false) { if (initialCapacity) reserve(initialCapacity); }
+        ~DynamicSink() { free0(buffer); }
+        DynamicSink(const DynamicSink &) = delete;
+        DynamicSink & operator = (const DynamicSink &) = delete;
+    };
+
+    /** A fixed size buffer sink that's never allocating.
+        The output is always zero terminated. If the output doesn't fit, it's truncated but the sink keeps counting the
+        bytes written so that getLength() returns the required size for the complete output */
+    struct FixedSink
+    {
+        char *       buffer;
+        const size_t size;
+        size_t       length;
+
+        void write(const char * data, size_t len)
+        {
+            if (length + 1 < size)
+            {
+                size_t c = min(len, size - 1 - length);
+                memcpy(buffer + length, data, c);
+                buffer[length + c] = 0;
+            }
+            length += len;
+        }
+        void put(const char c)     { if (length + 1 < size) { buffer[length] = c; buffer[length + 1] = 0; } length++; }
+        size_t getLength() const   { return length; }
+        bool isValid() const       { return length < size; }
+        /** Get a view on the (possibly truncated) output */
+        ROString view() const      { return ROString(buffer, (int)min(length, size ? size - 1 : 0)); }
+
+        /** Build a sink over a buffer of the given size in bytes (including the final zero) */
+        FixedSink(char * buffer, const size_t size) : buffer(buffer), size(size), length(0) { if (size) *buffer = 0; }
+        /** Build a sink over a fixed size array */
+        template <size_t N>
+        FixedSink(char (&buffer)[N]) : FixedSink(buffer, N) {}
+    };
+
+    /** A sink that's forwarding its output to a callback.
+        In order to avoid calling the callback for each single char, a small staging buffer is used on stack.
+        The callback is called when this buffer is full, or when the data to write is larger than the buffer.
+        Don't forget to call flush() when done */
+    template <size_t BufferSize = 64>
+    struct CallbackSinkT
+    {
+        Tools::function_ref<void(ROString)> callback;
+        char    staging[BufferSize];
+        size_t  used;
+        size_t  length;
+
+        void flush() { if (used) callback(ROString(staging, (int)used)); used = 0; }
+        void write(const char * data, size_t len)
+        {
+            length += len;
+            if (used + len > BufferSize)
+            {
+                flush();
+                if (len >= BufferSize) { callback(ROString(data, (int)len)); return; }
+            }
+            memcpy(staging + used, data, len); used += len;
+        }
+        void put(const char c)   { if (used == BufferSize) flush(); staging[used++] = c; length++; }
+        size_t getLength() const { return length; }
+        bool isValid() const     { return true; }
+
+        CallbackSinkT(Tools::function_ref<void(ROString)> callback) : callback(callback), used(0), length(0) {}
+        ~CallbackSinkT() { flush(); }
+    };
+    typedef CallbackSinkT<> CallbackSink;
+
+    /** A sink that's only counting the bytes written to it. This is used to compute the exact output size */
+    struct CountingSink
+    {
+        size_t length;
+
+        void write(const char *, size_t len) { length += len; }
+        void put(const char)                 { length++; }
+        size_t getLength() const             { return length; }
+        bool isValid() const                 { return true; }
+
+        CountingSink() : length(0) {}
+    };
+}
+
+#endif
@@ -0,0 +1,40 @@
+#include "unity.h"
+#include "JSON/JSONSerdes.hpp"
+
+namespace
+{
+    struct Item { ArenaString name; ArenaVector<int> values; };
+    struct Request { int id; ArenaVector<Item> items; };
+
+    const char * json = R"({"id":1,"items":[{"name":"a","values":[1,2,3,4,5,6,7,8]},{"name":"b","values":[9,10,11,12,13,14,15,16,17]}]})";
+}
+
+TEST_CASE("Arena deserialization reuses an object after the arena is reset", "[arena][json]")
+{
+    // Only heap blocks, so a reset frees the storage the previous deserialization used
+    Tools::BumpArena arena(64);
+    Request req;
+    for (int i = 0; i < 16; i++)
+    {
+        TEST_ASSERT_TRUE(deserialize(req, json, arena));
+        TEST_ASSERT_EQUAL(2, req.items.size());
+        TEST_ASSERT_EQUAL(17, req.items[1].values[8]);
+        arena.reset();
+    }
+    // Destructing the object requires live storage
+    TEST_ASSERT_TRUE(deserialize(req, json, arena));
+}
+
+TEST_CASE("Arena deserialization uses dedicated blocks when the arena is exhausted", "[arena][json]")
+{
+    // Room for the items and their names only, the values must overflow
+    alignas(max_align_t) char buffer[2 * sizeof(Item) + 16];
+    Tools::BumpArena arena(buffer);
+    Request req;
+    for (int i = 0; i < 16; i++)
+    {
+        arena.reset();
+        TEST_ASSERT_TRUE(deserialize(req, json, arena));
+        TEST_ASSERT_EQUAL(9, req.items[1].values.size());
+    }
+}